@@ -0,0 +1,56 @@
+#pragma once
+
+#include "SatEncoder.hpp"
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+
+/**
+ * Checks the circuit pairs of a manifest in parallel and writes one JSON line
+ * per pair as soon as its check has finished, i.e., the results are not
+ * necessarily in the order of the manifest.
+ *
+ * The manifest is a JSON Lines file with one pair per line, e.g.
+ *   {"id": "adder", "circuitOne": "a.qasm", "circuitTwo": "b.qasm",
+ *    "inputs": ["ZZ", "xZ"]}
+ * Relative paths are resolved against the directory of the manifest. The id
+ * defaults to the line number and the inputs to the all-zero state. Empty
+ * lines are skipped.
+ *
+ * Results are of the form
+ *   {"line": 1, "id": "adder", "equivalent": true, "result": "equivalent",
+ *    "reason": "", "statistics": {...}, "counterexample": {...} | null}
+ * or {"line": 1, "id": "adder", "error": "..."} if a pair cannot be checked.
+ */
+class BatchRunner {
+public:
+  /**
+   * @param threads number of checks running at the same time, 0 uses one per
+   * hardware thread
+   */
+  explicit BatchRunner(std::size_t threads = 0U) : nrOfThreads(threads) {}
+
+  // limits of every single check
+  void setLimits(const SatEncoder::Limits& newLimits) { limits = newLimits; }
+  void setMaxTCount(std::size_t count) { maxTCount = count; }
+
+  /**
+   * @return the number of pairs that could not be checked
+   */
+  std::size_t run(const std::string& manifestFile, std::ostream& output) const;
+
+  // relative paths of the manifest are resolved against directory
+  std::size_t run(std::istream& manifest, const std::string& directory,
+                  std::ostream& output) const;
+
+  // checks the pair of a single manifest line, throws if it cannot be checked
+  [[nodiscard]] json check(const json&        entry,
+                           const std::string& directory) const;
+
+private:
+  std::size_t        nrOfThreads;
+  SatEncoder::Limits limits{};
+  std::size_t        maxTCount = 16U;
+};
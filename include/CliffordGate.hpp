@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Gate types of the compact circuit format. The values are part of the
+ * Python interface and must not change. T and Tdg are the only non-Clifford
+ * gates, see SatEncoder::setMaxTCount.
+ */
+enum class GateType : std::uint8_t { I = 0, H, S, Sdg, X, Y, Z, T, Tdg };
+
+/**
+ * Single gate of a circuit in compact form. A controlled X (CNOT) is given by
+ * an X gate with a non-negative control.
+ */
+struct CliffordGate {
+  std::uint8_t type    = 0U; // see GateType
+  std::int32_t control = -1;
+  std::int32_t target  = 0;
+};
+
+/**
+ * Non-owning view of a circuit given as a contiguous array of gates.
+ *
+ * The optional layout describes routed circuits. Both arrays have nrOfQubits
+ * entries. Qubit i holds logical qubit outputPermutation[i] at the end of the
+ * circuit, and ancillary qubits (ancillary[i] != 0) start in |0> regardless
+ * of the input. Missing arrays denote the identity and no ancillas.
+ */
+struct CliffordCircuit {
+  std::size_t         nrOfQubits = 0U;
+  const CliffordGate* gates      = nullptr;
+  std::size_t         nrOfGates  = 0U;
+
+  const std::uint32_t* outputPermutation = nullptr;
+  const std::uint8_t*  ancillary         = nullptr;
+
+  [[nodiscard]] const CliffordGate* begin() const { return gates; }
+  [[nodiscard]] const CliffordGate* end() const { return gates + nrOfGates; }
+  [[nodiscard]] bool                empty() const { return nrOfGates == 0U; }
+};
+
+/**
+ * Storage of the layout of a CliffordCircuit.
+ */
+struct CircuitLayout {
+  std::vector<std::uint32_t> outputPermutation{}; // empty if the identity
+  std::vector<std::uint8_t>  ancillary{};         // empty if there are none
+};
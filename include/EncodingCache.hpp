@@ -0,0 +1,102 @@
+#pragma once
+
+#include "CliffordGate.hpp"
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Preprocessing result of a single circuit for a fixed set of inputs that is
+ * independent of the generator IDs of a particular SatEncoder. Generators are
+ * numbered locally in order of their first appearance, starting with the
+ * generators of the input states.
+ */
+struct CachedEncoding {
+  std::size_t              nrOfQubits = 0U;
+  std::size_t              nrOfGates  = 0U;
+  std::uint64_t            inputHash  = 0U; // see EncodingCache::hash
+  std::vector<std::size_t> inputGeneratorIds; // local id per input state
+  std::vector<std::map<std::size_t, std::size_t>>
+      generatorMappings; // one map per level, local ids
+  std::vector<std::vector<std::vector<bool>>>
+      generators; // local id <> generator
+  std::vector<std::uint64_t> content; // see EncodingCache::content
+};
+
+/**
+ * Content-addressed cache of circuit encodings. Entries are keyed by a hash
+ * of the circuit and the input states. The cache consists of an in-memory LRU
+ * tier and an optional on-disk tier in which every entry is stored as a
+ * separate file in the binary format of EncodingFormat.hpp. Entries of the
+ * disk tier are loaded into the in-memory tier on their first hit. Encodings
+ * that the format cannot represent are kept in memory only. The cache may be
+ * shared between several SatEncoder instances and threads.
+ */
+class EncodingCache {
+public:
+  /**
+   * @param maxEntries maximum number of entries kept in memory
+   * @param cacheDirectory directory of the on-disk tier. If empty, only the
+   * in-memory tier is used
+   */
+  explicit EncodingCache(std::size_t maxEntries     = 64U,
+                         std::string cacheDirectory = {});
+
+  /**
+   * @return the cached encoding or nullptr if there is none in either tier.
+   * An entry whose content differs from the given one belongs to a different
+   * circuit with the same key and is treated as missing
+   */
+  std::shared_ptr<const CachedEncoding>
+  find(const std::string& key, const std::vector<std::uint64_t>& content);
+
+  void insert(const std::string& key, CachedEncoding encoding);
+
+  /**
+   * @return the key of a circuit for the given inputs
+   */
+  static std::string key(const CliffordCircuit&          circuit,
+                         const std::vector<std::string>& inputs);
+
+  static std::uint64_t hash(const CliffordCircuit& circuit);
+  static std::uint64_t hash(const std::vector<std::string>& inputs);
+
+  /**
+   * @return the circuit and the inputs in a canonical form that is stored
+   * with every entry and compared on every hit, since keys are not unique
+   */
+  static std::vector<std::uint64_t>
+  content(const CliffordCircuit&          circuit,
+          const std::vector<std::string>& inputs);
+
+  [[nodiscard]] std::size_t size() const;
+
+private:
+  using LruList = std::list<std::string>;
+
+  struct Entry {
+    std::shared_ptr<const CachedEncoding> encoding;
+    LruList::iterator                     lruPosition;
+  };
+
+  // assumes the mutex is held
+  void insertInMemory(const std::string&                    key,
+                      std::shared_ptr<const CachedEncoding> encoding);
+
+  [[nodiscard]] std::string fileName(const std::string& key) const;
+
+  std::shared_ptr<const CachedEncoding> load(const std::string& key) const;
+  void store(const std::string& key, const CachedEncoding& encoding) const;
+
+  std::size_t                            capacity;
+  std::string                            directory;
+  LruList                                lru; // most recently used first
+  std::unordered_map<std::string, Entry> entries;
+  mutable std::mutex                     mutex;
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "EncodingCache.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Versioned binary format for preprocessed circuits (see CachedEncoding).
+ * All fields are 64-bit words in native byte order, such that every section
+ * can be accessed in place once the file is memory-mapped:
+ *
+ *   header            magic, version, and the sizes of all sections
+ *   generators        nrOfGenerators x nrOfRows x wordsPerRow packed rows
+ *   inputGeneratorIds one local generator id per input state
+ *   levelOffsets      nrOfLevels + 1 offsets into the mapping array
+ *   mappings          (from, to) pairs of local generator ids
+ *   content           the circuit and its inputs, see EncodingCache::content
+ *
+ * Bit j of a packed row is stored in bit j % 64 of word j / 64.
+ */
+struct EncodingHeader {
+  std::uint64_t magic;
+  std::uint64_t version;
+  std::uint64_t nrOfQubits;
+  std::uint64_t nrOfGates;
+  std::uint64_t inputHash;
+  std::uint64_t nrOfGenerators;
+  std::uint64_t nrOfRows;   // rows per generator
+  std::uint64_t rowBits;    // bits per row
+  std::uint64_t nrOfInputs; // input states
+  std::uint64_t nrOfLevels;
+  std::uint64_t nrOfMappings;
+  std::uint64_t nrOfContentWords;
+
+  static constexpr std::uint64_t MAGIC   = 0x434E45544153514FULL; // "OQSATENC"
+  static constexpr std::uint64_t VERSION = 2U;
+
+  [[nodiscard]] std::uint64_t wordsPerRow() const {
+    return rowBits / 64U + (rowBits % 64U != 0U ? 1U : 0U);
+  }
+};
+
+/**
+ * Zero-copy view of an encoding in the binary format. The view does not own
+ * the underlying memory.
+ */
+class EncodingView {
+public:
+  // throws std::runtime_error if the data is not a valid encoding, i.e., if
+  // any section does not fit the size or any offset or id is out of range
+  EncodingView(const void* data, std::size_t size);
+
+  [[nodiscard]] const EncodingHeader& header() const { return *head; }
+
+  [[nodiscard]] bool bit(std::size_t generatorId, std::size_t row,
+                         std::size_t column) const;
+
+  // materializes a single generator
+  [[nodiscard]] std::vector<std::vector<bool>>
+  generator(std::size_t generatorId) const;
+
+  [[nodiscard]] const std::uint64_t* inputGeneratorIds() const {
+    return inputIds;
+  }
+
+  // mappings of a level as [begin, end) of (from, to) pairs
+  [[nodiscard]] std::pair<const std::uint64_t*, const std::uint64_t*>
+  levelMappings(std::size_t level) const;
+
+  // copies the complete encoding
+  [[nodiscard]] CachedEncoding toEncoding() const;
+
+private:
+  const EncodingHeader* head;
+  const std::uint64_t*  generatorWords;
+  const std::uint64_t*  inputIds;
+  const std::uint64_t*  levelOffsets;
+  const std::uint64_t*  mappings;
+  const std::uint64_t*  content;
+};
+
+/**
+ * Read-only memory mapping of an encoding file.
+ */
+class MappedEncoding {
+public:
+  // throws std::runtime_error if the file cannot be read or is invalid
+  explicit MappedEncoding(const std::string& file);
+  ~MappedEncoding();
+
+  MappedEncoding(const MappedEncoding&)            = delete;
+  MappedEncoding& operator=(const MappedEncoding&) = delete;
+
+  [[nodiscard]] const EncodingView& view() const { return *encodingView; }
+
+private:
+  void*                         data = nullptr;
+  std::size_t                   size = 0U;
+  std::vector<std::uint64_t>    buffer; // used if memory mapping is unavailable
+  std::unique_ptr<EncodingView> encodingView;
+};
+
+// reads a complete encoding file without mapping it, throws
+// std::runtime_error if the file cannot be read or is invalid
+CachedEncoding readEncoding(const std::string& file);
+
+// true if all generators have the same number of rows of the same size,
+// which excludes, e.g., Pauli sums of circuits with T gates and mixed
+// symbolic and state inputs
+bool isRepresentable(const CachedEncoding& encoding);
+
+// throws std::invalid_argument if the encoding is not representable
+void writeEncoding(std::ostream& os, const CachedEncoding& encoding);
+
+// writes to a temporary file first and renames it afterwards, such that
+// readers never observe a partially written file
+void writeEncoding(const std::string& file, const CachedEncoding& encoding);
@@ -1,32 +1,330 @@
 #pragma once
 
-#include "CircuitOptimizer.hpp"
+#include "CliffordGate.hpp"
+#include "EncodingCache.hpp"
+#include "EncodingFormat.hpp"
 #include "QuantumComputation.hpp"
 #include "Statistics.hpp"
+#include "Z3ContextPool.hpp"
 
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <iomanip>
 #include <iostream>
+#include <limits>
 #include <locale>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
 #include <z3++.h>
 
 using json = nlohmann::json;
 
 class SatEncoder {
 public:
+  enum class SolverBackend {
+    SMT,       // default Z3 solver
+    BitVector, // Z3 QF_BV tactic
+    SAT        // bit-blasting followed by the Z3 SAT solver
+  };
+
+  struct SolverConfiguration {
+    std::string   name;
+    SolverBackend backend = SolverBackend::SMT;
+    unsigned      seed    = 0U;
+  };
+
+  /**
+   * Sets the solver configurations that are run in parallel whenever a SAT
+   * instance is checked. Each configuration gets its own thread and Z3
+   * context, the first configuration that produces an answer wins and all
+   * others are interrupted. If empty (default), a single default solver is
+   * used. Configurations differ in the backend and the seed only, all of
+   * them solve a copy of the same miter, i.e., the encoding of the generator
+   * ids as bit-vectors is not varied.
+   * @param configurations solver configurations of the portfolio
+   */
+  void setPortfolio(std::vector<SolverConfiguration> configurations);
+
+  /**
+   * @return a portfolio of different seeds and backends
+   */
+  static std::vector<SolverConfiguration> defaultPortfolio();
+
+  /**
+   * Time limits in milliseconds and memory limits in megabytes for a single
+   * call of testEqual or checkSatisfiability. A value of zero means unlimited.
+   * If a limit is hit, the call returns false and the statistics report an
+   * unknown result together with the reason.
+   */
+  struct Limits {
+    std::size_t timeout        = 0U; // whole call
+    std::size_t memory         = 0U; // whole call
+    std::size_t preprocTimeout = 0U; // preprocessing of both circuits
+    std::size_t preprocMemory  = 0U; // estimated size of the generator table
+    std::size_t solvingTimeout = 0U; // passed to Z3
+    std::size_t solvingMemory  = 0U; // passed to Z3
+  };
+
+  void setLimits(const Limits& newLimits);
+
+  /**
+   * Sets the maximum number of T/Tdg gates per circuit. Each T gate that acts
+   * on an X or Y component of a generator splits it into a sum of two Pauli
+   * operators, such that the size of the encoding grows exponentially in the
+   * T-count but not in the number of qubits. Circuits with more T gates are
+   * rejected with an unknown result.
+   * @param count maximum T-count, 16 by default. Larger values than
+   * MAX_T_COUNT are clamped, see Coefficient
+   */
+  void setMaxTCount(std::size_t count) {
+    maxTCount = std::min(count, MAX_T_COUNT);
+  }
+  static constexpr std::size_t MAX_T_COUNT = 60U;
+
+  /**
+   * Generators are identified by a fingerprint of two independent hashes
+   * during preprocessing and their bits are only materialized when needed,
+   * e.g., to decode a counterexample. Two different generators are only
+   * confused if both hashes collide. If verification is enabled, all
+   * generators are stored and compared on every fingerprint match, such that
+   * collisions are ruled out at the cost of memory.
+   */
+  void setVerifyGenerators(bool verify) { verifyGenerators = verify; }
+
+  /**
+   * The constraints of instances with at least minMappings generator mappings
+   * are built by multiple threads, each in its own z3 context, and translated
+   * into the solver afterwards.
+   * @param threads number of threads, 0 (default) uses one per hardware
+   * thread and 1 builds all constraints on the calling thread
+   */
+  void setConstructionThreads(std::size_t threads,
+                              std::size_t minMappings = 1U << 16U) {
+    constructionThreads = threads;
+    minParallelMappings = minMappings;
+  }
+
+  /**
+   * The tableaus of all inputs are stored every interval levels during
+   * preprocessing, such that materializing the generators of a
+   * counterexample and incremental checks (see testEqualAfterEdit) resume at
+   * the closest checkpoint instead of simulating from the first level. If
+   * the checkpoints of a circuit exceed the memory limit, the interval is
+   * doubled and every other checkpoint is dropped.
+   * @param interval levels between checkpoints, 0 (default) disables them
+   * except for incremental checks, which use about sqrt(depth) levels
+   * @param memory megabytes per circuit, 0 means unlimited
+   */
+  void setCheckpoints(std::size_t interval, std::size_t memory = 64U) {
+    checkpointInterval = interval;
+    checkpointMemory   = memory;
+  }
+
+  /**
+   * Input and output states that distinguish two circuits. Generators are
+   * given as Pauli strings with a leading sign, e.g. "-XZI".
+   */
+  struct Counterexample {
+    // input in the format accepted by testEqual, e.g. "xZ" == |+1>. Empty if
+    // the input is not a product of single-qubit stabilizer states
+    std::string              input;
+    std::vector<std::string> inputGenerators;
+    std::vector<std::string> outputGeneratorsOne;
+    std::vector<std::string> outputGeneratorsTwo;
+    // indices of the output generators that differ
+    std::vector<std::size_t> differingGenerators;
+
+    [[nodiscard]] json to_json() const {
+      return json{{"input", input},
+                  {"inputGenerators", inputGenerators},
+                  {"outputGeneratorsOne", outputGeneratorsOne},
+                  {"outputGeneratorsTwo", outputGeneratorsTwo},
+                  {"differingGenerators", differingGenerators}};
+    }
+
+    void from_json(const json& j) {
+      j.at("input").get_to(input);
+      j.at("inputGenerators").get_to(inputGenerators);
+      j.at("outputGeneratorsOne").get_to(outputGeneratorsOne);
+      j.at("outputGeneratorsTwo").get_to(outputGeneratorsTwo);
+      j.at("differingGenerators").get_to(differingGenerators);
+    }
+  };
+
+  /**
+   * Sets a cache for circuit encodings, which may be shared between several
+   * encoders. Circuits found in the cache are not preprocessed again.
+   * @param encodingCache cache to use, nullptr disables caching
+   */
+  void setCache(std::shared_ptr<EncodingCache> encodingCache);
+
+  /**
+   * @return the counterexample found by the last call of testEqual if the
+   * circuits were shown to be not equivalent
+   */
+  [[nodiscard]] const std::optional<Counterexample>& getCounterexample() const;
+
   /**
    * Takes two Clifford circuits, constructs SAT instance and checks if there is
    * an assignment that leads to outputs that differ.
    * @param circuit first circuit
    * @param circuitTwo second circuit
    * @param inputs input states to consider. In stabilizer representation, e.g.
-   * ZZ == |00>. If empty all-zero state is assumed.
+   * ZZ == |00>. If empty all-zero state is assumed. An input starting with a
+   * sign, e.g. +XZ, is a single Pauli operator that is propagated on its own
+   * (see allComputationalBasisInputs).
    * @return true if the circuits are equivalent (for given inputs)
    */
   bool testEqual(qc::QuantumComputation&         circuit,
                  qc::QuantumComputation&         circuitTwo,
                  const std::vector<std::string>& inputs);
 
+  /**
+   * Same as above for circuits in the compact format of CliffordGate.hpp,
+   * e.g., a NumPy array passed from Python. The gates are read in place
+   * without constructing a QuantumComputation or a DAG.
+   * @param circuitOne first circuit
+   * @param circuitTwo second circuit
+   * @param inputs input states to consider
+   * @return true if the circuits are equivalent (for given inputs)
+   */
+  bool testEqual(const CliffordCircuit&          circuitOne,
+                 const CliffordCircuit&          circuitTwo,
+                 const std::vector<std::string>& inputs);
+
+  /**
+   * Replacement of the gates [begin, end) of one circuit of an incremental
+   * check by the given gates.
+   */
+  struct CircuitEdit {
+    std::size_t               circuit = 1U; // 0 for the first circuit
+    std::size_t               begin   = 0U;
+    std::size_t               end     = 0U;
+    std::vector<CliffordGate> gates{};
+  };
+
+  /**
+   * Same as above, but keeps the generator table, the solver, and the
+   * tableaus of the inputs at a few checkpoints, such that the pair can be
+   * checked again after local edits (see testEqualAfterEdit). The circuits
+   * are copied. Any other check discards the kept state.
+   * @param circuitOne first circuit
+   * @param circuitTwo second circuit
+   * @param inputs input states to consider
+   * @return true if the circuits are equivalent (for given inputs)
+   */
+  bool testEqualIncremental(const CliffordCircuit&          circuitOne,
+                            const CliffordCircuit&          circuitTwo,
+                            const std::vector<std::string>& inputs);
+
+  /**
+   * Applies an edit to the pair of the last incremental check and checks it
+   * again. Only the levels from the first one the edit affects on are
+   * simulated again, starting at the closest checkpoint before, and only
+   * their constraints are retracted from the solver and added again. The
+   * solver has a z3 context of its own, such that edits may be checked on any
+   * thread. Edits that make a circuit invalid are rejected and leave the pair
+   * unchanged.
+   * @param edit gates to replace
+   * @return true if the edited circuits are equivalent (for the inputs of the
+   * incremental check)
+   */
+  bool testEqualAfterEdit(const CircuitEdit& edit);
+
+  /**
+   * Converts a circuit to the compact format of CliffordGate.hpp. The gates
+   * act on the physical qubits, i.e., the layout is ignored (see convert).
+   * @return the gates or nothing if the circuit contains unsupported gates
+   */
+  static std::optional<std::vector<CliffordGate>>
+  toGates(const qc::QuantumComputation& circuit);
+
+  // circuit in the compact format together with the storage of its view
+  struct ConvertedCircuit {
+    std::size_t               nrOfQubits = 0U;
+    std::vector<CliffordGate> gates{};
+    CircuitLayout             layout{};
+
+    [[nodiscard]] CliffordCircuit view() const;
+  };
+
+  /**
+   * Converts a (routed) circuit including its layout. The qubits are
+   * relabeled by the initial layout, such that the gates act on logical
+   * qubits and the output permutation is applied to the final tableau
+   * instead of undoing the routing. Logical ancillas are restricted to |0>
+   * in all inputs. Qubits missing in the output permutation
+   * (garbage) are compared as well. Circuits of different width are compared
+   * on the larger number of qubits with the additional qubits of the smaller
+   * one as ancillas.
+   * @return the circuit or nothing if it contains unsupported gates
+   */
+  static std::optional<ConvertedCircuit>
+  convert(const qc::QuantumComputation& circuit);
+
+  /**
+   * Inputs that cover all 2^n computational basis states. Instead of
+   * enumerating the states, the n operators Z_i are propagated individually
+   * and the solver chooses among them. Since the outputs for |b> are
+   * generated by (-1)^b_i C Z_i C^dagger, the circuits are equivalent for all
+   * basis states iff they agree on each Z_i.
+   * @param nrOfQubits number of qubits of the circuits
+   * @return inputs to pass to testEqual
+   */
+  static std::vector<std::string>
+  allComputationalBasisInputs(std::size_t nrOfQubits);
+
+  /**
+   * Inputs that cover all stabilizer states on the first k qubits (and all
+   * computational basis states on the remaining ones) by additionally
+   * propagating X_i for the first k qubits.
+   * @param nrOfQubits number of qubits of the circuits
+   * @param nrOfStabilizerQubits k
+   * @return inputs to pass to testEqual
+   */
+  static std::vector<std::string>
+  allStabilizerInputs(std::size_t nrOfQubits, std::size_t nrOfStabilizerQubits);
+
+  /**
+   * Constructs the SAT instance for two circuits that have been preprocessed
+   * before (see preprocessToFile) and checks if there is an assignment that
+   * leads to outputs that differ.
+   * @param circuitOne preprocessed first circuit
+   * @param circuitTwo preprocessed second circuit, for the same inputs
+   * @return true if the circuits are equivalent (for the inputs used during
+   * preprocessing)
+   */
+  bool testEqual(const EncodingView& circuitOne,
+                 const EncodingView& circuitTwo);
+
+  /**
+   * Preprocesses a Clifford circuit and stores the result in the binary format
+   * of EncodingFormat.hpp, such that it can be loaded by another process.
+   * Encodings that contain Pauli sums due to T gates or that mix symbolic
+   * and state inputs have no fixed row size and cannot be stored.
+   * @param circuit circuit to preprocess
+   * @param inputs input states to consider. If empty all-zero state is assumed.
+   * @param file file to write
+   * @return false if the circuit could not be preprocessed or stored
+   */
+  bool preprocessToFile(qc::QuantumComputation&         circuit,
+                        const std::vector<std::string>& inputs,
+                        const std::string&              file);
+
   /**
    * Takes two Clifford circuits, constructs SAT instance and checks if there is
    * an assignment that leads to outputs that differ with all zero state as
@@ -59,17 +357,142 @@ public:
   [[nodiscard]] const Statistics& getStats() const;
 
 private:
+  // (a + b * sqrt(2)) / 2^k, the coefficients of Pauli operators after
+  // conjugation with T gates. Since conjugation preserves the norm of the
+  // coefficient vector, also under sqrt(2) -> -sqrt(2), every coefficient
+  // after t T gates satisfies |a|, |b| <= 2^k with k <= t. Hence, the
+  // arithmetic on int64_t (including the intermediate results of operator+)
+  // is exact as long as t <= MAX_T_COUNT.
+  struct Coefficient {
+    std::int64_t a = 1;
+    std::int64_t b = 0;
+    std::uint8_t k = 0U;
+
+    static constexpr std::size_t BITS = 64U + 64U + 8U; // when encoded
+
+    [[nodiscard]] Coefficient operator-() const;
+    [[nodiscard]] Coefficient operator+(const Coefficient& other) const;
+    [[nodiscard]] Coefficient divideBySqrt2() const;
+    [[nodiscard]] bool        isZero() const { return a == 0 && b == 0; }
+    [[nodiscard]] bool        isUnit() const {
+      return b == 0 && k == 0U && (a == 1 || a == -1);
+    }
+    [[nodiscard]] double toDouble() const;
+    void                 normalize();
+  };
+
+  // hash of the bits of a generator. low and high form a 128-bit mixing
+  // hash, check is an unrelated polynomial hash modulo 2^61 - 1 that detects
+  // collisions of the former
+  struct Fingerprint {
+    std::uint64_t low   = 0U;
+    std::uint64_t high  = 0U;
+    std::uint64_t check = 0U;
+
+    bool operator==(const Fingerprint& other) const {
+      return low == other.low && high == other.high && check == other.check;
+    }
+  };
+
+  struct FingerprintHash {
+    std::size_t operator()(const Fingerprint& fingerprint) const {
+      return static_cast<std::size_t>(fingerprint.low);
+    }
+  };
+
+  // hashes the rows of a generator bit by bit without materializing it
+  class FingerprintBuilder {
+  public:
+    void        addRow(std::size_t size);
+    void        addBit(bool bit);
+    Fingerprint finish();
+
+  private:
+    void mix(std::uint64_t value);
+
+    std::uint64_t word     = 0U;
+    std::size_t   nrOfBits = 0U;
+    std::uint64_t low      = 0x243F6A8885A308D3ULL;
+    std::uint64_t high     = 0x13198A2E03707344ULL;
+    std::uint64_t check    = 0U;
+  };
+
+  static Fingerprint
+  fingerprintOf(const std::vector<std::vector<bool>>& generator);
+
   struct QState {
-    unsigned long                  n;
+    unsigned long                  n; // qubits, the number of rows may differ
     std::vector<std::vector<bool>> x;
     std::vector<std::vector<bool>> z;
     std::vector<int>               r;
     std::size_t                    prevGenId;
+    // once a T gate has been applied, every row of x, z, and r is a term of
+    // a Pauli sum. rowOf is the generator row a term belongs to (ascending)
+    // and the coefficient of a term is (-1)^r * coefficients.
+    std::vector<std::size_t> rowOf;
+    std::vector<Coefficient> coefficients;
 
     [[nodiscard]] std::vector<std::vector<bool>> getLevelGenerator() const;
+    // same as fingerprintOf(getLevelGenerator())
+    [[nodiscard]] Fingerprint fingerprint() const;
     void applyCNOT(unsigned long control, unsigned long target);
     void applyH(unsigned long target);
     void applyS(unsigned long target);
+    void applyT(unsigned long target, bool inverse);
+    // moves column i to column permutation[i]
+    void permuteColumns(const std::uint32_t* permutation);
+  };
+
+  // QState with the rows of x and z packed into words, e.g., for checkpoints
+  struct PackedQState {
+    std::size_t n         = 0U;
+    std::size_t nrOfRows  = 0U;
+    std::size_t prevGenId = 0U;
+    // x and z of each row, followed by the bits of r
+    std::vector<std::uint64_t> words{};
+    std::vector<std::size_t>   rowOf{};
+    std::vector<Coefficient>   coefficients{};
+
+    explicit PackedQState(const QState& state);
+
+    [[nodiscard]] QState      unpack() const;
+    [[nodiscard]] std::size_t bytes() const;
+  };
+
+  struct Checkpoint {
+    std::vector<PackedQState> states{}; // per input
+    std::size_t               bytes = 0U;
+  };
+
+  // bit-sliced tableau of at most 64 * Words qubits for circuits without T
+  // gates. Word w of column j holds bit j of the rows 64w to 64w + 63, such
+  // that a gate updates all rows with a few word operations. Generators and
+  // fingerprints are the same as for a QState.
+  template <std::size_t Words> struct FixedQState {
+    using Column = std::array<std::uint64_t, Words>;
+
+    static constexpr std::size_t MAX_QUBITS = 64U * Words;
+
+    std::size_t                    n        = 0U;
+    std::size_t                    nrOfRows = 0U;
+    std::array<Column, MAX_QUBITS> x{};
+    std::array<Column, MAX_QUBITS> z{};
+    Column                         r{};
+    std::size_t                    prevGenId = 0U;
+
+    // the state must not contain Pauli sums
+    explicit FixedQState(const QState& state);
+
+    [[nodiscard]] static bool bit(const Column& column, std::size_t row) {
+      return ((column[row / 64U] >> (row % 64U)) & 1U) != 0U;
+    }
+    [[nodiscard]] QState toQState() const;
+    [[nodiscard]] std::vector<std::vector<bool>> getLevelGenerator() const;
+    [[nodiscard]] Fingerprint                    fingerprint() const;
+    void applyCNOT(unsigned long control, unsigned long target);
+    void applyH(unsigned long target);
+    void applyS(unsigned long target);
+    void permuteColumns(const std::uint32_t* permutation);
   };
 
   class CircuitRepresentation {
@@ -78,30 +501,259 @@ private:
         generatorMappings; // list of generatorId <> generatorId maps. One map
                            // per level
     std::map<std::size_t, std::vector<std::vector<bool>>>
-        idGeneratorMap; // id <> generator map
+        idGeneratorMap; // id <> generator map, only complete if the
+                        // generators were materialized during preprocessing
+    std::vector<std::size_t> inputGeneratorIds; // id per input state
+    std::size_t              nrOfGates = 0U;
+    // preprocessed circuit and inputs to materialize generators, the circuit
+    // is empty if the representation was imported
+    CliffordCircuit          circuit{};
+    std::vector<std::string> inputs{};
+    // tableaus of all inputs before every checkpointInterval-th level (except
+    // level 0), only captured if the interval is non-zero
+    std::size_t                       checkpointInterval = 0U;
+    std::map<std::size_t, Checkpoint> checkpoints{};
+    std::size_t                       checkpointBytes = 0U;
+  };
+
+  // state of testEqualIncremental that is kept for testEqualAfterEdit. The
+  // solver is destroyed before the lease of its context
+  struct IncrementalCheck {
+    std::size_t                               nrOfQubits = 0U;
+    std::array<std::vector<CliffordGate>, 2U> gates{};
+    std::array<CircuitLayout, 2U>             layouts{};
+    std::vector<std::string>                  inputs{};
+    std::array<CircuitRepresentation, 2U>     representations{};
+    std::unique_ptr<Z3ContextPool::Lease>     z3{}; // owns its context
+    std::optional<z3::solver>                 solver{};
+    unsigned                                  bitwidth = 0U;
+    // one scope per level of the deeper circuit and one for the outputs
+    std::size_t nrOfScopes = 0U;
+
+    [[nodiscard]] CliffordCircuit circuit(std::size_t i) const;
   };
+  std::unique_ptr<IncrementalCheck> incremental;
 
-  std::map<std::vector<std::vector<bool>>, std::size_t>
-      generators; // generator <> id map for reverse lookup
+  std::unordered_multimap<Fingerprint, std::size_t, FingerprintHash>
+      generators; // fingerprint <> id map for reverse lookup
+  // generator per id, only stored if generators are verified
+  std::vector<std::vector<std::vector<bool>>> generatorContents;
+  bool                                        verifyGenerators = false;
+
+  // returns the id of a generator and whether it is new. materialize() is
+  // only called if the generator has to be compared or stored
+  template <class Materialize>
+  std::pair<std::size_t, bool>
+  findOrInsertGenerator(const Fingerprint& fingerprint,
+                        Materialize&&      materialize);
+
+  // recomputes a generator of a representation by simulating the input state
+  // it originates from
+  [[nodiscard]] std::vector<std::vector<bool>>
+  materializeGenerator(const SatEncoder::CircuitRepresentation& representation,
+                       std::size_t                              id) const;
+
+  // indices of the gates acting on each qubit, in order. A CNOT appears for
+  // both its control and its target (same levels as a qc::DAG)
+  static std::vector<std::vector<std::size_t>>
+  gatesPerQubit(const CliffordCircuit& circuit);
+  // a circuit without gates but with an output permutation has a single
+  // level that only applies the permutation, such that its outputs are not
+  // identified with its inputs
+  static std::size_t
+  nrOfLevelsOf(const CliffordCircuit&                       circuit,
+               const std::vector<std::vector<std::size_t>>& gatesOnQubit);
+
+  // applies the gates of a level to all states, and the output permutation
+  // after the last level. Returns the number of gates
+  template <class State>
+  static std::size_t
+  applyLevel(std::vector<State>& states, const CliffordCircuit& circuit,
+             const std::vector<std::vector<std::size_t>>& gatesOnQubit,
+             std::size_t                                  level,
+             bool                                         lastLevel);
+
+  // records the generators of the states for the levels of the circuit from
+  // firstLevel on, the states are the tableaus before firstLevel
+  template <class State>
+  void simulate(std::vector<State>& states, const CliffordCircuit& circuit,
+                const std::vector<std::vector<std::size_t>>& gatesOnQubit,
+                bool                                         storeGenerators,
+                SatEncoder::CircuitRepresentation&           representation,
+                std::size_t                                  firstLevel);
+
+  // same as above, tableaus of circuits without T gates are bit-sliced if
+  // they fit into a few words per column
+  void simulateStates(std::vector<QState>&                         states,
+                      const CliffordCircuit&                       circuit,
+                      const std::vector<std::vector<std::size_t>>& gatesOnQubit,
+                      bool storeGenerators,
+                      SatEncoder::CircuitRepresentation& representation,
+                      std::size_t                        firstLevel);
+
+  // extends a circuit by idle ancillas, the layout is stored in storage
+  static CliffordCircuit withWidth(const CliffordCircuit& circuit,
+                                   std::size_t            nrOfQubits,
+                                   CircuitLayout&         storage);
+
+  // sets the ancillas of the circuits to |0> in inputs that are states and
+  // drops operators with X or Y on an ancilla, which do not stabilize |0>
+  static std::vector<std::string>
+  restrictAncillas(const std::vector<std::string>&            inputs,
+                   const std::vector<const CliffordCircuit*>& circuits);
 
   static QState initializeState(unsigned long      nrOfInputs,
                                 const std::string& input);
 
-  static bool isClifford(const qc::QuantumComputation& qc);
+  // Clifford gates and T/Tdg
+  static bool isSupported(const qc::QuantumComputation& qc);
+  // checks gate types and qubit indices of a circuit in compact format
+  static bool isValid(const CliffordCircuit& circuit);
+  [[nodiscard]] bool exceedsMaxTCount(const CliffordCircuit& circuit) const;
 
+  // rejects circuits that cannot be compared and sets the unknown reason
+  bool acceptCircuits(const CliffordCircuit& circuitOne,
+                      const CliffordCircuit& circuitTwo);
+
+  // generators are only stored in the representation if storeGenerators is
+  // set, e.g., to export the encoding. Incremental checks store checkpoints
+  // even if they are disabled
   SatEncoder::CircuitRepresentation
-  preprocessCircuit(const qc::DAG& dag, const std::vector<std::string>& inputs);
+  preprocessCircuit(const CliffordCircuit&          circuit,
+                    const std::vector<std::string>& inputs,
+                    bool storeGenerators, bool incrementalCheck = false);
+
+  // stores the states as checkpoint before a level and thins out the
+  // checkpoints of the representation if they exceed the memory limit
+  template <class State>
+  void addCheckpoint(SatEncoder::CircuitRepresentation& representation,
+                     std::size_t level, const std::vector<State>& states);
 
+  // simulates the levels from firstLevel on again after the circuit of the
+  // representation has been replaced by an edited one, starting at the
+  // closest checkpoint. Returns the number of simulated levels
+  std::size_t
+  resumePreprocessing(SatEncoder::CircuitRepresentation& representation,
+                      const CliffordCircuit& circuit, std::size_t firstLevel);
+
+  // first level of a circuit whose generators change if the gates [begin,
+  // end) are replaced by the given ones
+  static std::size_t firstAffectedLevel(const CliffordCircuit& circuit,
+                                        const CliffordCircuit& edited,
+                                        const CircuitEdit&     edit);
+
+  // looks up the circuit in the cache before preprocessing it
+  SatEncoder::CircuitRepresentation
+  obtainRepresentation(const CliffordCircuit&          circuit,
+                       const std::vector<std::string>& inputs,
+                       bool                            storeGenerators = false);
+
+  // converts a representation to local generator ids and vice versa
+  [[nodiscard]] static CachedEncoding
+  exportEncoding(const SatEncoder::CircuitRepresentation& representation,
+                 const CliffordCircuit&                   circuit,
+                 const std::vector<std::string>&          inputs);
+  // Encoding is either a CachedEncoding or an EncodingView
+  template <class Encoding>
+  SatEncoder::CircuitRepresentation importEncoding(const Encoding& encoding);
+
+  // constructs and solves the miter of two preprocessed circuits
+  bool checkMiter(const SatEncoder::CircuitRepresentation& circOneRep,
+                  const SatEncoder::CircuitRepresentation& circTwoRep);
+
+  // solves a miter instance and records the result and a counterexample
+  bool solveMiter(z3::solver&                              solver,
+                  const SatEncoder::CircuitRepresentation& circOneRep,
+                  const SatEncoder::CircuitRepresentation& circTwoRep,
+                  unsigned                                 bitwidth);
+
+  // adds the miter constraints of the incremental check, the levels from
+  // firstLevel on replace the ones in the solver
+  void addIncrementalLevels(std::size_t firstLevel);
+
+  // the solver has to be created in the context of the lease
   void constructSatInstance(
       const SatEncoder::CircuitRepresentation& circuitRepresentation,
+      Z3ContextPool::Lease& z3,
       z3::solver& solver); // construct z3 instance. Assumes prepocessCircuit()
                            // has been run before.
   void constructMiterInstance(
       const SatEncoder::CircuitRepresentation& circuitOneRepresentation,
       const SatEncoder::CircuitRepresentation& circuitTwoRepresentation,
+      Z3ContextPool::Lease& z3,
       z3::solver& solver); // assumes preprocess circuit has been run before
 
-  bool isSatisfiable(z3::solver& solver);
+  // adds ([x^l]_2 = i) => ([x^l+1]_2 = k) for the generator mappings of the
+  // representations at the levels [firstLevel, endLevel), or <=> if
+  // equivalence is set. prefixes are the names of the variables of each
+  // representation, e.g. x^
+  void addMappingConstraints(
+      const std::vector<const SatEncoder::CircuitRepresentation*>&
+                                           representations,
+      const std::vector<std::string_view>& prefixes, bool equivalence,
+      unsigned bitwidth, Z3ContextPool::Lease& z3, z3::solver& solver,
+      std::size_t firstLevel = 0U,
+      std::size_t endLevel   = std::numeric_limits<std::size_t>::max());
+
+  // model is set to a satisfying assignment (in the context of the solver)
+  z3::check_result solve(z3::solver& solver, z3::model& model);
+
+  // resets the per-call budget and result. The generator table and the state
+  // of an incremental check are discarded unless the call continues it
+  void startCall(bool continueIncremental = false);
+
+  static std::size_t tightestLimit(std::size_t limit, std::size_t other);
+  static std::size_t
+  elapsedSince(const std::chrono::steady_clock::time_point& start);
+
+  // checked cooperatively after every level during preprocessing
+  bool preprocessingBudgetExceeded();
+
+  // returns false if there is no time left for solving
+  bool applySolvingLimits(z3::solver& solver) const;
+
+  // runs all configurations of the portfolio on a copy of the given solver
+  z3::check_result checkPortfolio(const z3::solver& solver, z3::model& model);
+
+  static z3::solver createSolver(z3::context&               ctx,
+                                 const SolverConfiguration& configuration);
+
+  void recordZ3Statistics(const z3::stats& z3Stats);
+
+  [[nodiscard]] std::size_t encodingBitwidth() const;
+
+  // decodes the miter variables of a satisfying assignment and materializes
+  // the respective generators
+  void extractCounterexample(
+      const z3::model&                         model,
+      const SatEncoder::CircuitRepresentation& circOneRep,
+      const SatEncoder::CircuitRepresentation& circTwoRep, unsigned bitwidth);
+
+  // rows that are Pauli sums are given as, e.g., "+0.7071XI-0.7071YI"
+  static std::vector<std::string>
+  toPauliStrings(const std::vector<std::vector<bool>>& generator,
+                 std::size_t                           nrOfQubits);
+
+  static std::string toInputString(const std::vector<std::vector<bool>>& generator);
+
+  std::vector<SolverConfiguration> portfolio;
+
+  Limits                                limits;
+  std::chrono::steady_clock::time_point callStart;
+  std::chrono::steady_clock::time_point preprocStart;
+  std::size_t                           preprocMemory = 0U;
+
+  std::optional<Counterexample> counterexample;
+
+  std::shared_ptr<EncodingCache> cache;
+
+  std::size_t maxTCount = 16U;
+
+  std::size_t constructionThreads = 0U;
+  std::size_t minParallelMappings = 1U << 16U;
+
+  std::size_t checkpointInterval = 0U;
+  std::size_t checkpointMemory   = 64U;
 
   Statistics  stats;
   std::size_t nrOfInputGenerators = 0U;
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "SatEncoder.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Checks the equivalence of two circuits for a large set of input states by
+ * splitting the inputs into shards. Every shard is an independent miter and
+ * the circuits are equivalent iff all shards are unsatisfiable. Shards are
+ * either checked by local worker processes or written to task files that are
+ * processed by other nodes. As soon as one shard yields a counterexample, the
+ * remaining shards are cancelled. The statistics of all shards are merged
+ * (see Statistics::merge).
+ *
+ * Results are exchanged as JSON objects of the form
+ *   {"shard": i, "statistics": {...}, "counterexample": {...} | null}
+ * over a pipe (forked workers) or in the file "shard-<i>.result.json" next to
+ * the task file "shard-<i>.task.json" (spawned workers and remote nodes).
+ */
+class ShardedChecker {
+public:
+  /**
+   * @param workers number of local worker processes running at the same
+   * time, 0 uses one worker per hardware thread
+   */
+  explicit ShardedChecker(std::size_t workers = 0U);
+
+  // number of shards, 0 (default) uses one shard per worker
+  void setNrOfShards(std::size_t shards) { nrOfShards = shards; }
+  // limits of every single shard
+  void setLimits(const SatEncoder::Limits& newLimits) { limits = newLimits; }
+
+  /**
+   * Command that checks the task file given as its last argument (see
+   * runShardTask), e.g. {"qusat", "--shard-task"}. If set, local workers are
+   * started with posix_spawn and exchange tasks and results via files in a
+   * temporary directory.
+   */
+  void setWorkerCommand(std::vector<std::string> command) {
+    workerCommand = std::move(command);
+  }
+
+  /**
+   * Checks the shards of the inputs in local worker processes, which are
+   * started by the worker command if one is set. Otherwise, the workers are
+   * forked without exec, which is only safe as long as no other thread (of
+   * this library, z3, or the application) may hold a lock that the child
+   * needs. Hence, the shards are checked by threads of this process instead
+   * if the process has more than one thread or does not support fork.
+   * @return true if the circuits are equivalent for all inputs
+   */
+  bool testEqual(const CliffordCircuit&          circuitOne,
+                 const CliffordCircuit&          circuitTwo,
+                 const std::vector<std::string>& inputs);
+
+  bool testEqual(qc::QuantumComputation&         circuitOne,
+                 qc::QuantumComputation&         circuitTwo,
+                 const std::vector<std::string>& inputs);
+
+  /**
+   * Writes one task file per shard to a directory shared with other nodes.
+   * @return the number of shards written
+   */
+  std::size_t writeShardTasks(const std::string&              directory,
+                              const CliffordCircuit&          circuitOne,
+                              const CliffordCircuit&          circuitTwo,
+                              const std::vector<std::string>& inputs) const;
+
+  /**
+   * Checks a single shard and writes its result file. Tasks are skipped if
+   * the check has been cancelled by collectShardResults.
+   * @return false if the task was skipped
+   */
+  static bool runShardTask(const std::string& taskFile);
+
+  /**
+   * Merges the result files that are available in the directory and cancels
+   * all remaining tasks if one of them contains a counterexample.
+   * @return true if the check is complete, i.e., all results are available
+   * or a counterexample has been found
+   */
+  bool collectShardResults(const std::string& directory,
+                           std::size_t        nrOfTasks);
+
+  /**
+   * Splits the inputs into at most nrOfShards non-empty shards of similar
+   * size. No inputs (i.e., the all-zero state) form a single shard.
+   */
+  static std::vector<std::vector<std::string>>
+  partition(const std::vector<std::string>& inputs, std::size_t nrOfShards);
+
+  [[nodiscard]] const Statistics& getStats() const { return stats; }
+  [[nodiscard]] const std::optional<SatEncoder::Counterexample>&
+  getCounterexample() const {
+    return counterexample;
+  }
+  [[nodiscard]] json to_json() const { return stats.to_json(); }
+
+private:
+  // checks a single shard and returns its result object
+  static json runShard(std::size_t shard, const CliffordCircuit& circuitOne,
+                       const CliffordCircuit&          circuitTwo,
+                       const std::vector<std::string>& inputs,
+                       const SatEncoder::Limits&       limits);
+
+  // runs the shards and stops as soon as a counterexample is found
+  std::vector<json>
+  runWorkers(const CliffordCircuit& circuitOne,
+             const CliffordCircuit& circuitTwo,
+             const std::vector<std::vector<std::string>>& shards) const;
+  // runs the shards in threads of this process instead
+  std::vector<json>
+  runThreads(const CliffordCircuit& circuitOne,
+             const CliffordCircuit& circuitTwo,
+             const std::vector<std::vector<std::string>>& shards) const;
+
+  void writeTasks(const std::string& directory,
+                  const CliffordCircuit& circuitOne,
+                  const CliffordCircuit& circuitTwo,
+                  const std::vector<std::vector<std::string>>& shards) const;
+
+  // sets the statistics and the counterexample
+  void mergeResults(std::vector<json> results);
+
+  [[nodiscard]] std::size_t effectiveNrOfShards() const;
+
+  std::size_t                               nrOfWorkers;
+  std::size_t                               nrOfShards = 0U;
+  SatEncoder::Limits                        limits{};
+  std::vector<std::string>                  workerCommand{};
+  Statistics                                stats;
+  std::optional<SatEncoder::Counterexample> counterexample;
+};
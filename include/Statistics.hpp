@@ -4,9 +4,19 @@
 
 #ifndef QUSAT_STATISTICS_H
 #define QUSAT_STATISTICS_H
+#include <algorithm>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
+
+enum class EquivalenceResult { NotEquivalent, Equivalent, Unknown };
+
+NLOHMANN_JSON_SERIALIZE_ENUM(EquivalenceResult,
+                             {{EquivalenceResult::NotEquivalent,
+                               "not_equivalent"},
+                              {EquivalenceResult::Equivalent, "equivalent"},
+                              {EquivalenceResult::Unknown, "unknown"}})
+
 struct Statistics {
   std::size_t                   nrOfGates            = 0U;
   std::size_t                   nrOfQubits           = 0U;
@@ -18,9 +28,17 @@ struct Statistics {
   std::map<std::string, double> z3StatsMap;
   bool                          equal               = false;
   bool                          satisfiable         = false;
+  EquivalenceResult             result = EquivalenceResult::Unknown;
+  std::string                   unknownReason{};
   std::size_t                   preprocTime         = 0U;
   std::size_t                   solvingTime         = 0U;
   std::size_t                   satConstructionTime = 0U;
+  std::string                   solverConfiguration{};
+  std::size_t                   cacheHits = 0U;
+  std::size_t                   nrOfShards = 0U; // merged checks, see merge
+  // levels simulated again by the last incremental check after an edit
+  std::size_t nrOfResimulatedLevels = 0U;
+  std::size_t nrOfCheckpoints       = 0U; // stored during preprocessing
 
   [[nodiscard]] json to_json() const {
     return json{{"numGates", nrOfGates},
@@ -32,9 +50,16 @@ struct Statistics {
                 {"numInputs", nrOfDiffInputStates},
                 {"equivalent", equal},
                 {"satisfiable", satisfiable},
+                {"result", result},
+                {"unknownReason", unknownReason},
                 {"preprocTime", preprocTime},
                 {"solvingTime", solvingTime},
                 {"satConstructionTime", satConstructionTime},
+                {"solverConfiguration", solverConfiguration},
+                {"cacheHits", cacheHits},
+                {"numShards", nrOfShards},
+                {"numResimulatedLevels", nrOfResimulatedLevels},
+                {"numCheckpoints", nrOfCheckpoints},
                 {"z3map", z3StatsMap}
 
     };
@@ -54,6 +79,62 @@ struct Statistics {
     j.at("solvingTime").get_to(solvingTime);
     j.at("satConstructionTime").get_to(satConstructionTime);
     j.at("z3map").get_to(z3StatsMap);
+    if (j.contains("result")) {
+      j.at("result").get_to(result);
+      j.at("unknownReason").get_to(unknownReason);
+    }
+    if (j.contains("solverConfiguration")) {
+      j.at("solverConfiguration").get_to(solverConfiguration);
+    }
+    if (j.contains("cacheHits")) {
+      j.at("cacheHits").get_to(cacheHits);
+    }
+    if (j.contains("numShards")) {
+      j.at("numShards").get_to(nrOfShards);
+    }
+    if (j.contains("numResimulatedLevels")) {
+      j.at("numResimulatedLevels").get_to(nrOfResimulatedLevels);
+    }
+    if (j.contains("numCheckpoints")) {
+      j.at("numCheckpoints").get_to(nrOfCheckpoints);
+    }
+  }
+
+  /**
+   * Combines the statistics of an independent check, e.g., of another shard
+   * of the input states. Sizes of the circuits are maximized, sizes of the
+   * instances and times are summed up (times thus correspond to CPU time).
+   * A counterexample in any check makes the result not equivalent, otherwise
+   * an unknown result in any check makes it unknown.
+   */
+  void merge(const Statistics& other) {
+    nrOfGates             = std::max(nrOfGates, other.nrOfGates);
+    nrOfQubits            = std::max(nrOfQubits, other.nrOfQubits);
+    circuitDepth          = std::max(circuitDepth, other.circuitDepth);
+    nrOfSatVars          += other.nrOfSatVars;
+    nrOfGenerators       += other.nrOfGenerators;
+    nrOfFunctionalConstr += other.nrOfFunctionalConstr;
+    nrOfDiffInputStates  += other.nrOfDiffInputStates;
+    for (const auto& [key, value] : other.z3StatsMap) {
+      z3StatsMap[key] += value;
+    }
+    satisfiable = satisfiable || other.satisfiable;
+    if (nrOfShards == 0U ||
+        other.result == EquivalenceResult::NotEquivalent ||
+        (result == EquivalenceResult::Equivalent &&
+         other.result == EquivalenceResult::Unknown)) {
+      result              = other.result;
+      unknownReason       = other.unknownReason;
+      solverConfiguration = other.solverConfiguration;
+    }
+    equal                  = result == EquivalenceResult::Equivalent;
+    preprocTime           += other.preprocTime;
+    solvingTime           += other.solvingTime;
+    satConstructionTime   += other.satConstructionTime;
+    cacheHits             += other.cacheHits;
+    nrOfResimulatedLevels += other.nrOfResimulatedLevels;
+    nrOfCheckpoints       += other.nrOfCheckpoints;
+    nrOfShards            += std::max<std::size_t>(other.nrOfShards, 1U);
   }
 
   [[nodiscard]] std::string toString() const {
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed number of worker threads that run submitted tasks in submission
+ * order. Tasks must not throw.
+ */
+class ThreadPool {
+public:
+  // defaults to the number of hardware threads
+  explicit ThreadPool(std::size_t nrOfThreads = 0U);
+  // runs all tasks that are still queued before joining the workers
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&)            = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  void submit(std::function<void()> task);
+
+  [[nodiscard]] std::size_t size() const { return workers.size(); }
+
+private:
+  void work();
+
+  std::vector<std::thread>          workers;
+  std::queue<std::function<void()>> tasks;
+  std::mutex                        mutex;
+  std::condition_variable           taskAvailable;
+  bool                              stopping = false;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <z3++.h>
+
+/**
+ * z3 contexts that are reused by consecutive checks on the same thread.
+ * Creating a context and rebuilding the same constants dominates the run time
+ * of small checks. Since a z3::context must not be shared between threads,
+ * every thread owns its own context. Terms that are no longer referenced stay
+ * interned in a context, hence it is replaced by a fresh one after a number
+ * of checks.
+ */
+class Z3ContextPool {
+  struct Context; // a z3 context and its cached constants
+
+public:
+  /**
+   * Access to the context of the calling thread for the duration of a check.
+   * Leases may be nested, the context is only replaced if no lease is active.
+   */
+  class Lease {
+  public:
+    struct Owned {};
+
+    Lease();
+    /**
+     * Lease of a fresh context that belongs to no thread, e.g., for a solver
+     * that is kept beyond the call that created it. It may be used and
+     * destroyed on any thread, but only on one at a time.
+     */
+    explicit Lease(Owned);
+    ~Lease();
+
+    Lease(const Lease&)            = delete;
+    Lease& operator=(const Lease&) = delete;
+
+    [[nodiscard]] z3::context& ctx();
+
+    // bit-vector constant, cached per bitwidth
+    [[nodiscard]] z3::expr value(std::uint64_t value, unsigned bitwidth);
+
+  private:
+    // fixed on construction, the destructor may run on another thread
+    Context*                 context;
+    std::unique_ptr<Context> owned;
+  };
+
+  /**
+   * Number of checks after which the context of a thread is replaced, 0
+   * creates a new context for every check.
+   */
+  static void setMaxReuses(std::size_t reuses);
+
+  /**
+   * Bit-vector variable "<prefix><index>", e.g. x^3. The name is built
+   * without allocating.
+   */
+  static z3::expr variable(z3::context& ctx, std::string_view prefix,
+                           std::size_t index, unsigned bitwidth);
+
+private:
+  static Context& threadContext();
+};
@@ -0,0 +1,94 @@
+#include "BatchRunner.hpp"
+
+#include "CircuitOptimizer.hpp"
+#include "ThreadPool.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+
+std::size_t BatchRunner::run(const std::string& manifestFile,
+                             std::ostream&      output) const {
+  std::ifstream ifs(manifestFile);
+  if (!ifs.good()) {
+    throw std::runtime_error("Could not read " + manifestFile);
+  }
+  return run(ifs, std::filesystem::path(manifestFile).parent_path().string(),
+             output);
+}
+
+std::size_t BatchRunner::run(std::istream&      manifest,
+                             const std::string& directory,
+                             std::ostream&      output) const {
+  std::mutex  mutex;
+  std::size_t nrOfErrors = 0U;
+  const auto  write      = [&](const json& result) {
+    const std::lock_guard lock(mutex);
+    if (result.contains("error")) {
+      nrOfErrors++;
+    }
+    output << result.dump() << '\n' << std::flush;
+  };
+
+  {
+    // lines are checked while the manifest is read, the pool waits for all
+    // checks when it goes out of scope
+    ThreadPool  pool(nrOfThreads);
+    std::string line{};
+    for (std::size_t lineNr = 1U; std::getline(manifest, line); lineNr++) {
+      if (line.find_first_not_of(" \t\r") == std::string::npos) {
+        continue;
+      }
+      pool.submit([this, &write, &directory, line, lineNr]() {
+        json result{{"line", lineNr}, {"id", std::to_string(lineNr)}};
+        try {
+          const auto entry = json::parse(line);
+          if (entry.contains("id")) {
+            result["id"] = entry.at("id");
+          }
+          result.update(check(entry, directory));
+        } catch (const std::exception& e) {
+          result["error"] = e.what();
+        }
+        write(result);
+      });
+    }
+  }
+  return nrOfErrors;
+}
+
+json BatchRunner::check(const json& entry, const std::string& directory) const {
+  const auto import = [&directory](qc::QuantumComputation& circuit,
+                                   const json&             path) {
+    std::filesystem::path file(path.get<std::string>());
+    if (file.is_relative() && !directory.empty()) {
+      file = std::filesystem::path(directory) / file;
+    }
+    circuit.import(file.string());
+    qc::CircuitOptimizer::flattenOperations(circuit);
+  };
+  qc::QuantumComputation circuitOne{};
+  qc::QuantumComputation circuitTwo{};
+  import(circuitOne, entry.at("circuitOne"));
+  import(circuitTwo, entry.at("circuitTwo"));
+  std::vector<std::string> inputs{};
+  if (entry.contains("inputs")) {
+    entry.at("inputs").get_to(inputs);
+  }
+
+  SatEncoder encoder{};
+  encoder.setLimits(limits);
+  encoder.setMaxTCount(maxTCount);
+  const auto  equivalent = encoder.testEqual(circuitOne, circuitTwo, inputs);
+  const auto& stats      = encoder.getStats();
+  json        result{{"equivalent", equivalent},
+                     {"result", stats.result},
+                     {"reason", stats.unknownReason},
+                     {"statistics", stats.to_json()},
+                     {"counterexample", nullptr}};
+  if (const auto& counterexample = encoder.getCounterexample()) {
+    result["counterexample"] = counterexample->to_json();
+  }
+  return result;
+}
@@ -0,0 +1,206 @@
+#include "EncodingCache.hpp"
+
+#include "EncodingFormat.hpp"
+
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+constexpr std::uint64_t FNV_OFFSET = 14695981039346656037ULL;
+constexpr std::uint64_t FNV_PRIME  = 1099511628211ULL;
+
+void hashCombine(std::uint64_t& hash, std::uint64_t value) {
+  for (std::size_t i = 0U; i < sizeof(value); i++) {
+    hash ^= (value >> (8U * i)) & 0xFFU;
+    hash *= FNV_PRIME;
+  }
+}
+
+void appendString(std::vector<std::uint64_t>& words, const std::string& str) {
+  words.emplace_back(str.size());
+  for (std::size_t i = 0U; i < str.size(); i++) {
+    if (i % 8U == 0U) {
+      words.emplace_back(0U);
+    }
+    const auto byte = static_cast<unsigned char>(str[i]);
+    words.back() |= static_cast<std::uint64_t>(byte) << (8U * (i % 8U));
+  }
+}
+
+std::string toHex(std::uint64_t value) {
+  std::stringstream ss{};
+  ss << std::hex << std::setw(16) << std::setfill('0') << value;
+  return ss.str();
+}
+} // namespace
+
+EncodingCache::EncodingCache(std::size_t maxEntries, std::string cacheDirectory)
+    : capacity(maxEntries), directory(std::move(cacheDirectory)) {
+  if (!directory.empty()) {
+    std::filesystem::create_directories(directory);
+  }
+}
+
+std::shared_ptr<const CachedEncoding>
+EncodingCache::find(const std::string&                key,
+                    const std::vector<std::uint64_t>& content) {
+  {
+    const std::lock_guard lock(mutex);
+    if (const auto it = entries.find(key); it != entries.end()) {
+      if (it->second.encoding->content != content) {
+        return nullptr;
+      }
+      lru.splice(lru.begin(), lru, it->second.lruPosition);
+      return it->second.encoding;
+    }
+  }
+  if (directory.empty()) {
+    return nullptr;
+  }
+  auto encoding = load(key);
+  if (encoding != nullptr && encoding->content != content) {
+    return nullptr;
+  }
+  if (encoding != nullptr) {
+    const std::lock_guard lock(mutex);
+    insertInMemory(key, encoding);
+  }
+  return encoding;
+}
+
+void EncodingCache::insert(const std::string& key, CachedEncoding encoding) {
+  auto entry = std::make_shared<const CachedEncoding>(std::move(encoding));
+  if (!directory.empty()) {
+    store(key, *entry);
+  }
+  const std::lock_guard lock(mutex);
+  insertInMemory(key, std::move(entry));
+}
+
+void EncodingCache::insertInMemory(
+    const std::string& key, std::shared_ptr<const CachedEncoding> encoding) {
+  if (capacity == 0U) {
+    return;
+  }
+  if (const auto it = entries.find(key); it != entries.end()) {
+    it->second.encoding = std::move(encoding);
+    lru.splice(lru.begin(), lru, it->second.lruPosition);
+    return;
+  }
+  if (entries.size() >= capacity) {
+    entries.erase(lru.back());
+    lru.pop_back();
+  }
+  lru.emplace_front(key);
+  entries.emplace(key, Entry{std::move(encoding), lru.begin()});
+}
+
+std::size_t EncodingCache::size() const {
+  const std::lock_guard lock(mutex);
+  return entries.size();
+}
+
+std::string EncodingCache::key(const CliffordCircuit&          circuit,
+                               const std::vector<std::string>& inputs) {
+  return toHex(hash(circuit)) + "-" + toHex(hash(inputs));
+}
+
+std::uint64_t EncodingCache::hash(const std::vector<std::string>& inputs) {
+  auto result = FNV_OFFSET;
+  hashCombine(result, inputs.size());
+  for (const auto& input : inputs) {
+    hashCombine(result, input.size());
+    for (const auto c : input) {
+      hashCombine(result, static_cast<std::uint64_t>(c));
+    }
+  }
+  return result;
+}
+
+std::uint64_t EncodingCache::hash(const CliffordCircuit& circuit) {
+  auto result = FNV_OFFSET;
+  hashCombine(result, circuit.nrOfQubits);
+  hashCombine(result, circuit.nrOfGates);
+  for (const auto& gate : circuit) {
+    hashCombine(result, gate.type);
+    hashCombine(result, static_cast<std::uint64_t>(gate.control));
+    hashCombine(result, static_cast<std::uint64_t>(gate.target));
+  }
+  // circuits without a layout keep their hash
+  if (circuit.outputPermutation != nullptr) {
+    hashCombine(result, 'P');
+    for (std::size_t i = 0U; i < circuit.nrOfQubits; i++) {
+      hashCombine(result, circuit.outputPermutation[i]);
+    }
+  }
+  if (circuit.ancillary != nullptr) {
+    hashCombine(result, 'A');
+    for (std::size_t i = 0U; i < circuit.nrOfQubits; i++) {
+      hashCombine(result, circuit.ancillary[i]);
+    }
+  }
+  return result;
+}
+
+std::vector<std::uint64_t>
+EncodingCache::content(const CliffordCircuit&          circuit,
+                       const std::vector<std::string>& inputs) {
+  std::vector<std::uint64_t> words{circuit.nrOfQubits, circuit.nrOfGates};
+  words.reserve(2U * circuit.nrOfGates + 3U * circuit.nrOfQubits);
+  for (const auto& gate : circuit) {
+    words.emplace_back(gate.type);
+    words.emplace_back(
+        (static_cast<std::uint64_t>(static_cast<std::uint32_t>(gate.control))
+         << 32U) |
+        static_cast<std::uint32_t>(gate.target));
+  }
+  words.emplace_back(circuit.outputPermutation != nullptr ? 1U : 0U);
+  if (circuit.outputPermutation != nullptr) {
+    words.insert(words.end(), circuit.outputPermutation,
+                 circuit.outputPermutation + circuit.nrOfQubits);
+  }
+  words.emplace_back(circuit.ancillary != nullptr ? 1U : 0U);
+  if (circuit.ancillary != nullptr) {
+    words.insert(words.end(), circuit.ancillary,
+                 circuit.ancillary + circuit.nrOfQubits);
+  }
+  words.emplace_back(inputs.size());
+  for (const auto& input : inputs) {
+    appendString(words, input);
+  }
+  return words;
+}
+
+std::string EncodingCache::fileName(const std::string& key) const {
+  return (std::filesystem::path(directory) / (key + ".qsat")).string();
+}
+
+std::shared_ptr<const CachedEncoding>
+EncodingCache::load(const std::string& key) const {
+  const auto file = fileName(key);
+  if (!std::filesystem::exists(file)) {
+    return nullptr;
+  }
+  // entries are copied into the in-memory tier anyway, so the file is read
+  // instead of mapped. Invalid entries are treated as missing
+  try {
+    return std::make_shared<const CachedEncoding>(readEncoding(file));
+  } catch (const std::exception&) {
+    return nullptr;
+  }
+}
+
+void EncodingCache::store(const std::string&    key,
+                          const CachedEncoding& encoding) const {
+  // the disk tier is best effort and skips encodings the format cannot
+  // represent, e.g., Pauli sums of circuits with T gates
+  if (!isRepresentable(encoding)) {
+    return;
+  }
+  try {
+    writeEncoding(fileName(key), encoding);
+  } catch (const std::exception&) {
+    // the entry is still kept in memory
+  }
+}
@@ -0,0 +1,295 @@
+#include "EncodingFormat.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+// reads a file into a buffer of 64-bit words, such that a view may be created
+std::vector<std::uint64_t> readWords(const std::string& file,
+                                     std::size_t&       size) {
+  std::ifstream ifs(file, std::ios::binary | std::ios::ate);
+  if (!ifs.good()) {
+    throw std::runtime_error("Could not open " + file);
+  }
+  size = static_cast<std::size_t>(ifs.tellg());
+  std::vector<std::uint64_t> words((size + sizeof(std::uint64_t) - 1U) /
+                                   sizeof(std::uint64_t));
+  ifs.seekg(0);
+  ifs.read(reinterpret_cast<char*>(words.data()),
+           static_cast<std::streamsize>(size));
+  if (!ifs.good()) {
+    throw std::runtime_error("Could not read " + file);
+  }
+  return words;
+}
+} // namespace
+
+EncodingView::EncodingView(const void* data, std::size_t size) {
+  if (size < sizeof(EncodingHeader) ||
+      reinterpret_cast<std::uintptr_t>(data) % alignof(std::uint64_t) != 0U) {
+    throw std::runtime_error("Invalid encoding: truncated header");
+  }
+  head = static_cast<const EncodingHeader*>(data);
+  if (head->magic != EncodingHeader::MAGIC) {
+    throw std::runtime_error("Invalid encoding: wrong magic number");
+  }
+  if (head->version != EncodingHeader::VERSION) {
+    throw std::runtime_error("Unsupported encoding version " +
+                             std::to_string(head->version));
+  }
+  // the sizes stem from the file, so every operation is checked for overflow
+  const auto multiply = [](std::uint64_t a, std::uint64_t b) {
+    if (a != 0U && b > std::numeric_limits<std::uint64_t>::max() / a) {
+      throw std::runtime_error("Invalid encoding: section sizes overflow");
+    }
+    return a * b;
+  };
+  const auto add = [](std::uint64_t a, std::uint64_t b) {
+    if (b > std::numeric_limits<std::uint64_t>::max() - a) {
+      throw std::runtime_error("Invalid encoding: section sizes overflow");
+    }
+    return a + b;
+  };
+  const auto nrOfGeneratorWords = multiply(
+      multiply(head->nrOfGenerators, head->nrOfRows), head->wordsPerRow());
+  auto nrOfWords = add(nrOfGeneratorWords, head->nrOfInputs);
+  nrOfWords      = add(nrOfWords, add(head->nrOfLevels, 1U));
+  nrOfWords      = add(nrOfWords, multiply(2U, head->nrOfMappings));
+  nrOfWords      = add(nrOfWords, head->nrOfContentWords);
+  const auto nrOfDataBytes = size - sizeof(EncodingHeader);
+  if (nrOfDataBytes % sizeof(std::uint64_t) != 0U ||
+      nrOfDataBytes / sizeof(std::uint64_t) != nrOfWords) {
+    throw std::runtime_error("Invalid encoding: unexpected size");
+  }
+  generatorWords = reinterpret_cast<const std::uint64_t*>(head + 1);
+  inputIds       = generatorWords + nrOfGeneratorWords;
+  levelOffsets   = inputIds + head->nrOfInputs;
+  mappings       = levelOffsets + head->nrOfLevels + 1U;
+  content        = mappings + 2U * head->nrOfMappings;
+
+  if (levelOffsets[0] != 0U ||
+      levelOffsets[head->nrOfLevels] != head->nrOfMappings) {
+    throw std::runtime_error("Invalid encoding: inconsistent level offsets");
+  }
+  for (std::size_t level = 0U; level < head->nrOfLevels; level++) {
+    if (levelOffsets[level] > levelOffsets[level + 1U]) {
+      throw std::runtime_error("Invalid encoding: decreasing level offsets");
+    }
+  }
+  const auto validIds = [this](const std::uint64_t* begin,
+                               const std::uint64_t* end) {
+    return std::all_of(begin, end, [this](std::uint64_t id) {
+      return id < head->nrOfGenerators;
+    });
+  };
+  if (!validIds(inputIds, inputIds + head->nrOfInputs) ||
+      !validIds(mappings, mappings + 2U * head->nrOfMappings)) {
+    throw std::runtime_error("Invalid encoding: generator id out of range");
+  }
+}
+
+bool EncodingView::bit(std::size_t generatorId, std::size_t row,
+                       std::size_t column) const {
+  const auto  wordsPerRow = head->wordsPerRow();
+  const auto* rowWords =
+      generatorWords + (generatorId * head->nrOfRows + row) * wordsPerRow;
+  return ((rowWords[column / 64U] >> (column % 64U)) & 1U) != 0U;
+}
+
+std::vector<std::vector<bool>>
+EncodingView::generator(std::size_t generatorId) const {
+  std::vector<std::vector<bool>> result(head->nrOfRows,
+                                        std::vector<bool>(head->rowBits));
+  for (std::size_t row = 0U; row < head->nrOfRows; row++) {
+    for (std::size_t column = 0U; column < head->rowBits; column++) {
+      result[row][column] = bit(generatorId, row, column);
+    }
+  }
+  return result;
+}
+
+std::pair<const std::uint64_t*, const std::uint64_t*>
+EncodingView::levelMappings(std::size_t level) const {
+  return {mappings + 2U * levelOffsets[level],
+          mappings + 2U * levelOffsets[level + 1U]};
+}
+
+CachedEncoding EncodingView::toEncoding() const {
+  CachedEncoding encoding{};
+  encoding.nrOfQubits = head->nrOfQubits;
+  encoding.nrOfGates  = head->nrOfGates;
+  encoding.inputHash  = head->inputHash;
+  encoding.content.assign(content, content + head->nrOfContentWords);
+  encoding.inputGeneratorIds.assign(inputIds, inputIds + head->nrOfInputs);
+  encoding.generators.reserve(head->nrOfGenerators);
+  for (std::size_t i = 0U; i < head->nrOfGenerators; i++) {
+    encoding.generators.emplace_back(generator(i));
+  }
+  encoding.generatorMappings.resize(head->nrOfLevels);
+  for (std::size_t level = 0U; level < head->nrOfLevels; level++) {
+    const auto [begin, end] = levelMappings(level);
+    for (const auto* it = begin; it != end; it += 2) {
+      encoding.generatorMappings[level].emplace(it[0], it[1]);
+    }
+  }
+  return encoding;
+}
+
+MappedEncoding::MappedEncoding(const std::string& file) {
+#ifndef _WIN32
+  const int fd = ::open(file.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Could not open " + file);
+  }
+  struct stat fileStat{};
+  if (::fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+    ::close(fd);
+    throw std::runtime_error("Could not read " + file);
+  }
+  size = static_cast<std::size_t>(fileStat.st_size);
+  data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    data = nullptr;
+    throw std::runtime_error("Could not map " + file);
+  }
+  try {
+    encodingView = std::make_unique<EncodingView>(data, size);
+  } catch (...) {
+    ::munmap(data, size);
+    throw;
+  }
+#else
+  buffer       = readWords(file, size);
+  encodingView = std::make_unique<EncodingView>(buffer.data(), size);
+#endif
+}
+
+MappedEncoding::~MappedEncoding() {
+#ifndef _WIN32
+  if (data != nullptr) {
+    ::munmap(data, size);
+  }
+#endif
+}
+
+bool isRepresentable(const CachedEncoding& encoding) {
+  if (encoding.generators.empty()) {
+    return true;
+  }
+  const auto& first = encoding.generators.front();
+  return std::all_of(
+      encoding.generators.begin(), encoding.generators.end(),
+      [&first](const std::vector<std::vector<bool>>& generator) {
+        return generator.size() == first.size() &&
+               std::all_of(generator.begin(), generator.end(),
+                           [&first](const std::vector<bool>& row) {
+                             return row.size() == first.front().size();
+                           });
+      });
+}
+
+void writeEncoding(std::ostream& os, const CachedEncoding& encoding) {
+  if (!isRepresentable(encoding)) {
+    throw std::invalid_argument("Generators differ in their number or size of "
+                                "rows");
+  }
+  EncodingHeader header{};
+  header.magic          = EncodingHeader::MAGIC;
+  header.version        = EncodingHeader::VERSION;
+  header.nrOfQubits     = encoding.nrOfQubits;
+  header.nrOfGates      = encoding.nrOfGates;
+  header.inputHash      = encoding.inputHash;
+  header.nrOfGenerators = encoding.generators.size();
+  if (!encoding.generators.empty() && !encoding.generators.front().empty()) {
+    header.nrOfRows = encoding.generators.front().size();
+    header.rowBits  = encoding.generators.front().front().size();
+  }
+  header.nrOfInputs = encoding.inputGeneratorIds.size();
+  header.nrOfLevels = encoding.generatorMappings.size();
+  for (const auto& level : encoding.generatorMappings) {
+    header.nrOfMappings += level.size();
+  }
+  header.nrOfContentWords = encoding.content.size();
+
+  const auto writeWords = [&os](const std::vector<std::uint64_t>& words) {
+    os.write(reinterpret_cast<const char*>(words.data()),
+             static_cast<std::streamsize>(words.size() *
+                                          sizeof(std::uint64_t)));
+  };
+  os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  const auto                 wordsPerRow = header.wordsPerRow();
+  std::vector<std::uint64_t> words(header.nrOfRows * wordsPerRow);
+  for (const auto& generator : encoding.generators) {
+    std::fill(words.begin(), words.end(), 0U);
+    for (std::size_t row = 0U; row < generator.size(); row++) {
+      for (std::size_t column = 0U; column < header.rowBits; column++) {
+        if (generator[row].at(column)) {
+          words[row * wordsPerRow + column / 64U] |= 1ULL << (column % 64U);
+        }
+      }
+    }
+    writeWords(words);
+  }
+
+  writeWords({encoding.inputGeneratorIds.begin(),
+              encoding.inputGeneratorIds.end()});
+
+  words.clear();
+  words.emplace_back(0U);
+  for (const auto& level : encoding.generatorMappings) {
+    words.emplace_back(words.back() + level.size());
+  }
+  writeWords(words);
+
+  words.clear();
+  for (const auto& level : encoding.generatorMappings) {
+    for (const auto& [from, to] : level) {
+      words.emplace_back(from);
+      words.emplace_back(to);
+    }
+  }
+  writeWords(words);
+  writeWords(encoding.content);
+}
+
+CachedEncoding readEncoding(const std::string& file) {
+  std::size_t size  = 0U;
+  const auto  words = readWords(file, size);
+  return EncodingView(words.data(), size).toEncoding();
+}
+
+void writeEncoding(const std::string& file, const CachedEncoding& encoding) {
+  std::stringstream tmpName{};
+  tmpName << file << "." << std::hex << std::random_device{}() << ".tmp";
+  std::error_code ec{};
+  try {
+    std::ofstream ofs(tmpName.str(), std::ios::binary);
+    writeEncoding(ofs, encoding);
+    if (!ofs.good()) {
+      throw std::runtime_error("Could not write " + file);
+    }
+  } catch (...) {
+    std::filesystem::remove(tmpName.str(), ec);
+    throw;
+  }
+  std::filesystem::rename(tmpName.str(), file, ec);
+  if (ec) {
+    std::filesystem::remove(tmpName.str(), ec);
+    throw std::runtime_error("Could not write " + file + ": " + ec.message());
+  }
+}
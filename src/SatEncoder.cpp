@@ -1,32 +1,421 @@
 #include "SatEncoder.hpp"
 
+namespace {
+// permutation of all qubits, qubits that are missing in the given one (e.g.,
+// garbage outputs) are assigned the unused logical qubits in ascending order
+std::vector<std::uint32_t> completePermutation(const qc::Permutation& given,
+                                               std::size_t nrOfQubits) {
+  std::vector<std::uint32_t> result(nrOfQubits);
+  std::vector<bool>          assigned(nrOfQubits);
+  std::vector<bool>          used(nrOfQubits);
+  for (const auto& [physical, logical] : given) {
+    if (physical < nrOfQubits && logical < nrOfQubits && !used[logical]) {
+      result[physical]   = static_cast<std::uint32_t>(logical);
+      assigned[physical] = true;
+      used[logical]      = true;
+    }
+  }
+  std::size_t next = 0U;
+  for (std::size_t physical = 0U; physical < nrOfQubits; physical++) {
+    if (assigned[physical]) {
+      continue;
+    }
+    while (used[next]) {
+      next++;
+    }
+    result[physical] = static_cast<std::uint32_t>(next);
+    used[next]       = true;
+  }
+  return result;
+}
+
+constexpr std::uint64_t MERSENNE_61 = (1ULL << 61U) - 1U;
+
+// a * b mod 2^61 - 1 for a, b < 2^61 without 128-bit integers
+std::uint64_t mulMod61(std::uint64_t a, std::uint64_t b) {
+  const std::uint64_t aLow   = a & 0xFFFFFFFFU;
+  const std::uint64_t aHigh  = a >> 32U;
+  const std::uint64_t bLow   = b & 0xFFFFFFFFU;
+  const std::uint64_t bHigh  = b >> 32U;
+  const std::uint64_t low    = aLow * bLow;
+  const std::uint64_t middle = aLow * bHigh + bLow * aHigh;
+  const std::uint64_t high   = aHigh * bHigh;
+  // 2^64 = 8 and 2^61 = 1 modulo 2^61 - 1
+  std::uint64_t result = (low & MERSENNE_61) + (low >> 61U) + (high << 3U) +
+                         (middle >> 29U) + ((middle << 35U) >> 3U) + 1U;
+  result = (result & MERSENNE_61) + (result >> 61U);
+  result = (result & MERSENNE_61) + (result >> 61U);
+  return result - 1U;
+}
+
+// uniform access to the two formats of preprocessed circuits
+std::size_t nrOfGenerators(const CachedEncoding& encoding) {
+  return encoding.generators.size();
+}
+std::size_t nrOfGenerators(const EncodingView& encoding) {
+  return encoding.header().nrOfGenerators;
+}
+
+const std::vector<std::vector<bool>>& generatorOf(const CachedEncoding& encoding,
+                                                  std::size_t           id) {
+  return encoding.generators.at(id);
+}
+std::vector<std::vector<bool>> generatorOf(const EncodingView& encoding,
+                                           std::size_t         id) {
+  return encoding.generator(id);
+}
+
+std::vector<std::size_t> inputGeneratorIdsOf(const CachedEncoding& encoding) {
+  return encoding.inputGeneratorIds;
+}
+std::vector<std::size_t> inputGeneratorIdsOf(const EncodingView& encoding) {
+  const auto* ids = encoding.inputGeneratorIds();
+  return {ids, ids + encoding.header().nrOfInputs};
+}
+
+std::size_t nrOfLevels(const CachedEncoding& encoding) {
+  return encoding.generatorMappings.size();
+}
+std::size_t nrOfLevels(const EncodingView& encoding) {
+  return encoding.header().nrOfLevels;
+}
+
+template <class Function>
+void forEachMapping(const CachedEncoding& encoding, std::size_t level,
+                    Function&& function) {
+  for (const auto& [from, to] : encoding.generatorMappings[level]) {
+    function(from, to);
+  }
+}
+template <class Function>
+void forEachMapping(const EncodingView& encoding, std::size_t level,
+                    Function&& function) {
+  const auto [begin, end] = encoding.levelMappings(level);
+  for (const auto* it = begin; it != end; it += 2) {
+    function(static_cast<std::size_t>(it[0]), static_cast<std::size_t>(it[1]));
+  }
+}
+
+std::size_t nrOfGatesOf(const CachedEncoding& encoding) {
+  return encoding.nrOfGates;
+}
+std::size_t nrOfGatesOf(const EncodingView& encoding) {
+  return encoding.header().nrOfGates;
+}
+} // namespace
+
 bool SatEncoder::testEqual(qc::QuantumComputation&         circuitOne,
                            qc::QuantumComputation&         circuitTwo,
                            const std::vector<std::string>& inputs) {
-  if (!isClifford(circuitOne) || !isClifford(circuitTwo)) {
+  const auto convertedOne = convert(circuitOne);
+  const auto convertedTwo = convert(circuitTwo);
+  if (!convertedOne || !convertedTwo) {
+    startCall();
     std::cerr << "Circuits are not Clifford circuits" << std::endl;
+    stats.unknownReason = "circuits are not Clifford circuits";
     return false;
   }
-  if (circuitOne.empty() || circuitTwo.empty()) {
-    std::cerr << "Both circuits must be non-empy" << std::endl;
+  return testEqual(convertedOne->view(), convertedTwo->view(), inputs);
+}
+
+bool SatEncoder::testEqual(const CliffordCircuit&          circuitOne,
+                           const CliffordCircuit&          circuitTwo,
+                           const std::vector<std::string>& inputs) {
+  startCall();
+  if (!acceptCircuits(circuitOne, circuitTwo)) {
     return false;
   }
-  stats.nrOfDiffInputStates = inputs.size();
-  stats.nrOfQubits          = circuitOne.getNqubits();
-  qc::DAG dagOne            = qc::CircuitOptimizer::constructDAG(circuitOne);
-  qc::DAG dagTwo            = qc::CircuitOptimizer::constructDAG(circuitTwo);
+  // the smaller circuit is extended by ancillas, which are restricted to |0>
+  // in both circuits such that the inputs agree
+  const auto nrOfQubits =
+      std::max(circuitOne.nrOfQubits, circuitTwo.nrOfQubits);
+  CircuitLayout layoutOne{};
+  CircuitLayout layoutTwo{};
+  const auto    paddedOne  = withWidth(circuitOne, nrOfQubits, layoutOne);
+  const auto    paddedTwo  = withWidth(circuitTwo, nrOfQubits, layoutTwo);
+  const auto    restricted = restrictAncillas(inputs, {&paddedOne, &paddedTwo});
+  stats.nrOfDiffInputStates = restricted.size();
+  stats.nrOfQubits          = nrOfQubits;
   SatEncoder::CircuitRepresentation circOneRep =
-      preprocessCircuit(dagOne, inputs);
+      obtainRepresentation(paddedOne, restricted);
+  if (!stats.unknownReason.empty()) {
+    return false;
+  }
   SatEncoder::CircuitRepresentation circTwoRep =
-      preprocessCircuit(dagTwo, inputs);
-  z3::context ctx{};
-  z3::solver  solver(ctx);
-  constructMiterInstance(circOneRep, circTwoRep, solver);
+      obtainRepresentation(paddedTwo, restricted);
+  if (!stats.unknownReason.empty()) {
+    return false;
+  }
+  return checkMiter(circOneRep, circTwoRep);
+}
 
-  bool equal  = !isSatisfiable(solver);
-  stats.equal = equal;
+bool SatEncoder::acceptCircuits(const CliffordCircuit& circuitOne,
+                                const CliffordCircuit& circuitTwo) {
+  if (!isValid(circuitOne) || !isValid(circuitTwo)) {
+    std::cerr << "Circuits are not Clifford circuits" << std::endl;
+    stats.unknownReason = "circuits are not Clifford circuits";
+    return false;
+  }
+  if (circuitOne.empty() || circuitTwo.empty()) {
+    std::cerr << "Both circuits must be non-empy" << std::endl;
+    stats.unknownReason = "circuits are empty";
+    return false;
+  }
+  if (exceedsMaxTCount(circuitOne) || exceedsMaxTCount(circuitTwo)) {
+    std::cerr << "Circuits contain more than " << maxTCount << " T gates"
+              << std::endl;
+    stats.unknownReason = "T-count limit exceeded";
+    return false;
+  }
+  return true;
+}
 
-  return equal;
+bool SatEncoder::testEqual(const EncodingView& circuitOne,
+                           const EncodingView& circuitTwo) {
+  startCall();
+  if (circuitOne.header().inputHash != circuitTwo.header().inputHash ||
+      circuitOne.header().nrOfInputs != circuitTwo.header().nrOfInputs) {
+    std::cerr << "Circuits were preprocessed for different inputs"
+              << std::endl;
+    stats.unknownReason = "circuits were preprocessed for different inputs";
+    return false;
+  }
+  stats.nrOfDiffInputStates = circuitOne.header().nrOfInputs;
+  stats.nrOfQubits          = circuitOne.header().nrOfQubits;
+  const auto circOneRep     = importEncoding(circuitOne);
+  const auto circTwoRep     = importEncoding(circuitTwo);
+  return checkMiter(circOneRep, circTwoRep);
+}
+
+bool SatEncoder::preprocessToFile(qc::QuantumComputation&         circuit,
+                                  const std::vector<std::string>& inputs,
+                                  const std::string&              file) {
+  startCall();
+  const auto converted = convert(circuit);
+  if (!converted) {
+    std::cerr << "Circuit is not Clifford Circuit." << std::endl;
+    stats.unknownReason = "circuit is not a Clifford circuit";
+    return false;
+  }
+  const auto gateCircuit = converted->view();
+  if (exceedsMaxTCount(gateCircuit)) {
+    stats.unknownReason = "T-count limit exceeded";
+    return false;
+  }
+  const auto representation = obtainRepresentation(gateCircuit, inputs, true);
+  if (!stats.unknownReason.empty()) {
+    return false;
+  }
+  const auto encoding = exportEncoding(representation, gateCircuit, inputs);
+  if (!isRepresentable(encoding)) {
+    stats.unknownReason = "encoding is not representable in the file format";
+    return false;
+  }
+  try {
+    writeEncoding(file, encoding);
+  } catch (const std::exception& e) {
+    stats.unknownReason = e.what();
+    return false;
+  }
+  return true;
+}
+
+bool SatEncoder::checkMiter(
+    const SatEncoder::CircuitRepresentation& circOneRep,
+    const SatEncoder::CircuitRepresentation& circTwoRep) {
+  Z3ContextPool::Lease z3{};
+  z3::solver           solver(z3.ctx());
+  constructMiterInstance(circOneRep, circTwoRep, z3, solver);
+  return solveMiter(solver, circOneRep, circTwoRep,
+                    static_cast<unsigned>(encodingBitwidth()));
+}
+
+bool SatEncoder::solveMiter(
+    z3::solver& solver, const SatEncoder::CircuitRepresentation& circOneRep,
+    const SatEncoder::CircuitRepresentation& circTwoRep, unsigned bitwidth) {
+  z3::model  model(solver.ctx());
+  const auto result = solve(solver, model);
+  if (result == z3::check_result::unknown) {
+    return false;
+  }
+  if (result == z3::check_result::sat) {
+    extractCounterexample(model, circOneRep, circTwoRep, bitwidth);
+  }
+  stats.equal  = result == z3::check_result::unsat;
+  stats.result = stats.equal ? EquivalenceResult::Equivalent
+                             : EquivalenceResult::NotEquivalent;
+  return stats.equal;
+}
+
+bool SatEncoder::testEqualIncremental(const CliffordCircuit& circuitOne,
+                                      const CliffordCircuit& circuitTwo,
+                                      const std::vector<std::string>& inputs) {
+  startCall();
+  if (!acceptCircuits(circuitOne, circuitTwo)) {
+    return false;
+  }
+  auto check        = std::make_unique<IncrementalCheck>();
+  check->nrOfQubits = std::max(circuitOne.nrOfQubits, circuitTwo.nrOfQubits);
+  const std::array<const CliffordCircuit*, 2U> circuits{&circuitOne,
+                                                        &circuitTwo};
+  for (std::size_t i = 0U; i < circuits.size(); i++) {
+    // the gates and the (padded) layout are copied, since edits change them
+    CircuitLayout padding{};
+    const auto    padded = withWidth(*circuits[i], check->nrOfQubits, padding);
+    auto&         layout = check->layouts[i];
+    check->gates[i].assign(padded.begin(), padded.end());
+    if (padded.outputPermutation != nullptr) {
+      layout.outputPermutation.assign(
+          padded.outputPermutation,
+          padded.outputPermutation + check->nrOfQubits);
+    }
+    if (padded.ancillary != nullptr) {
+      layout.ancillary.assign(padded.ancillary,
+                              padded.ancillary + check->nrOfQubits);
+    }
+  }
+  const auto paddedOne = check->circuit(0U);
+  const auto paddedTwo = check->circuit(1U);
+  check->inputs        = restrictAncillas(inputs, {&paddedOne, &paddedTwo});
+  stats.nrOfDiffInputStates = check->inputs.size();
+  stats.nrOfQubits          = check->nrOfQubits;
+  for (std::size_t i = 0U; i < circuits.size(); i++) {
+    check->representations[i] =
+        preprocessCircuit(check->circuit(i), check->inputs, false, true);
+    if (!stats.unknownReason.empty()) {
+      return false;
+    }
+  }
+  check->z3 = std::make_unique<Z3ContextPool::Lease>(
+      Z3ContextPool::Lease::Owned{});
+  check->solver.emplace(check->z3->ctx());
+  incremental = std::move(check);
+  addIncrementalLevels(0U);
+  return solveMiter(*incremental->solver, incremental->representations[0],
+                    incremental->representations[1], incremental->bitwidth);
+}
+
+bool SatEncoder::testEqualAfterEdit(const CircuitEdit& edit) {
+  startCall(true);
+  if (incremental == nullptr) {
+    std::cerr << "No incremental check to continue" << std::endl;
+    stats.unknownReason = "no incremental check";
+    return false;
+  }
+  auto& check = *incremental;
+  if (edit.circuit >= check.gates.size() || edit.begin > edit.end ||
+      edit.end > check.gates[edit.circuit].size()) {
+    std::cerr << "Edit out of range" << std::endl;
+    stats.unknownReason = "invalid edit";
+    return false;
+  }
+  auto&                     gates = check.gates[edit.circuit];
+  std::vector<CliffordGate> edited{};
+  edited.reserve(gates.size() - (edit.end - edit.begin) + edit.gates.size());
+  const auto begin = gates.begin() + static_cast<std::ptrdiff_t>(edit.begin);
+  const auto end   = gates.begin() + static_cast<std::ptrdiff_t>(edit.end);
+  edited.insert(edited.end(), gates.begin(), begin);
+  edited.insert(edited.end(), edit.gates.begin(), edit.gates.end());
+  edited.insert(edited.end(), end, gates.end());
+  auto editedCircuit      = check.circuit(edit.circuit);
+  editedCircuit.gates     = edited.data();
+  editedCircuit.nrOfGates = edited.size();
+  if (!acceptCircuits(editedCircuit, check.circuit(1U - edit.circuit))) {
+    return false;
+  }
+
+  const auto level =
+      firstAffectedLevel(check.circuit(edit.circuit), editedCircuit, edit);
+  gates                       = std::move(edited);
+  stats.nrOfResimulatedLevels = resumePreprocessing(
+      check.representations[edit.circuit], check.circuit(edit.circuit), level);
+  if (!stats.unknownReason.empty()) {
+    // the representation is incomplete
+    incremental.reset();
+    return false;
+  }
+  addIncrementalLevels(level);
+  return solveMiter(*check.solver, check.representations[0],
+                    check.representations[1], check.bitwidth);
+}
+
+CliffordCircuit SatEncoder::IncrementalCheck::circuit(std::size_t i) const {
+  CliffordCircuit result{nrOfQubits, gates[i].data(), gates[i].size()};
+  if (!layouts[i].outputPermutation.empty()) {
+    result.outputPermutation = layouts[i].outputPermutation.data();
+  }
+  if (!layouts[i].ancillary.empty()) {
+    result.ancillary = layouts[i].ancillary.data();
+  }
+  return result;
+}
+
+void SatEncoder::addIncrementalLevels(std::size_t firstLevel) {
+  auto        before = std::chrono::high_resolution_clock::now();
+  auto&       check  = *incremental;
+  auto&       z3     = *check.z3;
+  auto&       ctx    = z3.ctx();
+  auto&       solver = *check.solver;
+  const auto& repOne = check.representations[0];
+  const auto& repTwo = check.representations[1];
+
+  // the generators of edits are added to the table. One spare bit avoids
+  // building the instance again with a larger bitwidth after most edits
+  const auto generatorCnt = generators.size();
+  stats.nrOfGenerators    = generatorCnt;
+  if (check.bitwidth == 0U ||
+      generatorCnt > (std::uint64_t{1} << check.bitwidth)) {
+    solver.reset();
+    check.nrOfScopes = 0U;
+    check.bitwidth   = static_cast<unsigned>(encodingBitwidth()) + 1U;
+    const auto inputOne =
+        Z3ContextPool::variable(ctx, "x^", 0U, check.bitwidth);
+    const auto inputTwo =
+        Z3ContextPool::variable(ctx, "x'^", 0U, check.bitwidth);
+    const auto nrOfInputs = z3.value(nrOfInputGenerators, check.bitwidth);
+    solver.add(inputOne == inputTwo);
+    solver.add(ult(inputOne, nrOfInputs));
+    solver.add(ult(inputTwo, nrOfInputs));
+    stats.nrOfSatVars += 2U;
+  }
+  // every level of both circuits has its own scope, such that the levels
+  // from the first affected one on can be retracted
+  if (check.nrOfScopes > firstLevel) {
+    solver.pop(static_cast<unsigned>(check.nrOfScopes - firstLevel));
+    check.nrOfScopes = firstLevel;
+  }
+  const auto width    = check.bitwidth;
+  const auto blocking = generatorCnt < (std::uint64_t{1} << width);
+  const auto depthOne = repOne.generatorMappings.size();
+  const auto depthTwo = repTwo.generatorMappings.size();
+  for (auto level = check.nrOfScopes; level < std::max(depthOne, depthTwo);
+       level++) {
+    solver.push();
+    addMappingConstraints({&repOne, &repTwo}, {"x^", "x'^"}, true, width, z3,
+                          solver, level, level + 1U);
+    // [x^l+1]_2 < m, earlier levels keep their bound since their generators
+    // did not change
+    const std::array<std::pair<std::string_view, std::size_t>, 2U> circuits{
+        {{"x^", depthOne}, {"x'^", depthTwo}}};
+    for (const auto& [prefix, depth] : circuits) {
+      if (level < depth) {
+        stats.nrOfSatVars++;
+        if (blocking) {
+          const auto var =
+              Z3ContextPool::variable(ctx, prefix, level + 1U, width);
+          solver.add(ult(var, z3.value(generatorCnt, width)));
+        }
+      }
+    }
+  }
+  solver.push();
+  solver.add(Z3ContextPool::variable(ctx, "x^", depthOne, width) !=
+             Z3ContextPool::variable(ctx, "x'^", depthTwo, width));
+  check.nrOfScopes = std::max(depthOne, depthTwo) + 1U;
+  auto after       = std::chrono::high_resolution_clock::now();
+  stats.satConstructionTime =
+      std::chrono::duration_cast<std::chrono::milliseconds>(after - before)
+          .count();
 }
 
 bool SatEncoder::testEqual(qc::QuantumComputation& circuitOne,
@@ -42,27 +431,134 @@ bool SatEncoder::checkSatisfiability(qc::QuantumComputation& circuitOne) {
 
 bool SatEncoder::checkSatisfiability(qc::QuantumComputation&         circuitOne,
                                      const std::vector<std::string>& inputs) {
-  if (!isClifford(circuitOne)) {
+  startCall();
+  const auto converted = convert(circuitOne);
+  if (!converted) {
     std::cerr << "Circuit is not Clifford Circuit." << std::endl;
+    stats.unknownReason = "circuit is not a Clifford circuit";
+    return false;
+  }
+  const auto gateCircuit = converted->view();
+  if (exceedsMaxTCount(gateCircuit)) {
+    stats.unknownReason = "T-count limit exceeded";
     return false;
   }
   stats.nrOfDiffInputStates = inputs.size();
   stats.nrOfQubits          = circuitOne.getNqubits();
-  qc::DAG     dag           = qc::CircuitOptimizer::constructDAG(circuitOne);
-  auto        circRep       = preprocessCircuit(dag, inputs);
-  z3::context ctx{};
-  z3::solver  solver(ctx);
-  constructSatInstance(circRep, solver);
+  auto circRep              = obtainRepresentation(gateCircuit, inputs);
+  if (!stats.unknownReason.empty()) {
+    return false;
+  }
+  Z3ContextPool::Lease z3{};
+  z3::solver           solver(z3.ctx());
+  constructSatInstance(circRep, z3, solver);
 
-  stats.satisfiable = this->isSatisfiable(solver);
+  z3::model model(z3.ctx());
+  solve(solver, model);
   return stats.satisfiable;
 }
 
-bool SatEncoder::isSatisfiable(z3::solver& solver) {
+void SatEncoder::setLimits(const Limits& newLimits) { limits = newLimits; }
+
+void SatEncoder::setCache(std::shared_ptr<EncodingCache> encodingCache) {
+  cache = std::move(encodingCache);
+}
+
+void SatEncoder::startCall(bool continueIncremental) {
+  callStart     = std::chrono::steady_clock::now();
+  preprocStart  = callStart;
+  preprocMemory = 0U;
+  counterexample.reset();
+  if (!continueIncremental) {
+    incremental.reset();
+    generators.clear();
+    generatorContents.clear();
+    uniqueGenCnt        = 0U;
+    nrOfInputGenerators = 0U;
+  }
+  stats.result        = EquivalenceResult::Unknown;
+  stats.unknownReason = "";
+  stats.equal         = false;
+  stats.satisfiable   = false;
+}
+
+std::size_t SatEncoder::tightestLimit(std::size_t limit, std::size_t other) {
+  if (limit == 0U) {
+    return other;
+  }
+  if (other == 0U) {
+    return limit;
+  }
+  return std::min(limit, other);
+}
+
+std::size_t SatEncoder::elapsedSince(
+    const std::chrono::steady_clock::time_point& start) {
+  return static_cast<std::size_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count());
+}
+
+bool SatEncoder::preprocessingBudgetExceeded() {
+  const auto callElapsed    = elapsedSince(callStart);
+  const auto preprocElapsed = elapsedSince(preprocStart);
+  if ((limits.timeout != 0U && callElapsed >= limits.timeout) ||
+      (limits.preprocTimeout != 0U &&
+       preprocElapsed >= limits.preprocTimeout)) {
+    stats.unknownReason = "preprocessing timeout";
+    return true;
+  }
+  const auto memoryLimit = tightestLimit(limits.memory, limits.preprocMemory);
+  if (memoryLimit != 0U && preprocMemory >= memoryLimit * 1024U * 1024U) {
+    stats.unknownReason = "preprocessing memory limit exceeded";
+    return true;
+  }
+  return false;
+}
+
+bool SatEncoder::applySolvingLimits(z3::solver& solver) const {
+  z3::params params(solver.ctx());
+  auto       timeout = limits.solvingTimeout;
+  if (limits.timeout != 0U) {
+    const auto callElapsed = elapsedSince(callStart);
+    if (callElapsed >= limits.timeout) {
+      return false;
+    }
+    timeout = tightestLimit(timeout, limits.timeout - callElapsed);
+  }
+  if (timeout != 0U) {
+    params.set("timeout", static_cast<unsigned>(timeout));
+  }
+  const auto memory = tightestLimit(limits.memory, limits.solvingMemory);
+  if (memory != 0U) {
+    params.set("max_memory", static_cast<unsigned>(memory));
+  }
+  solver.set(params);
+  return true;
+}
+
+z3::check_result SatEncoder::solve(z3::solver& solver, z3::model& model) {
   stats.satisfiable = false;
   auto before       = std::chrono::high_resolution_clock::now();
-  auto sat          = solver.check();
-  auto after        = std::chrono::high_resolution_clock::now();
+  z3::check_result sat;
+  if (portfolio.empty()) {
+    if (applySolvingLimits(solver)) {
+      sat = solver.check();
+      if (sat == z3::check_result::unknown) {
+        stats.unknownReason = solver.reason_unknown();
+      } else if (sat == z3::check_result::sat) {
+        model = solver.get_model();
+      }
+    } else {
+      sat                 = z3::check_result::unknown;
+      stats.unknownReason = "timeout";
+    }
+    recordZ3Statistics(solver.statistics());
+  } else {
+    sat = checkPortfolio(solver, model);
+  }
+  auto after = std::chrono::high_resolution_clock::now();
   auto z3SolvingDuration =
       std::chrono::duration_cast<std::chrono::milliseconds>(after - before)
           .count();
@@ -71,151 +567,891 @@ bool SatEncoder::isSatisfiable(z3::solver& solver) {
   if (sat == z3::check_result::sat) {
     stats.satisfiable = true;
   }
+  return sat;
+}
 
-  for (size_t i = 0; i < solver.statistics().size(); i++) {
-    auto   key = solver.statistics().key(i);
+void SatEncoder::recordZ3Statistics(const z3::stats& z3Stats) {
+  for (unsigned i = 0; i < z3Stats.size(); i++) {
+    auto   key = z3Stats.key(i);
     double val;
-    if (solver.statistics().is_double(i)) {
-      val = solver.statistics().double_value(i);
+    if (z3Stats.is_double(i)) {
+      val = z3Stats.double_value(i);
     } else {
-      val = solver.statistics().uint_value(i);
+      val = z3Stats.uint_value(i);
     }
     stats.z3StatsMap.emplace(key, val);
   }
-  return stats.satisfiable;
+}
+
+void SatEncoder::setPortfolio(std::vector<SolverConfiguration> configurations) {
+  portfolio = std::move(configurations);
+}
+
+std::vector<SatEncoder::SolverConfiguration> SatEncoder::defaultPortfolio() {
+  return {{"smt-seed-0", SolverBackend::SMT, 0U},
+          {"smt-seed-1", SolverBackend::SMT, 1U},
+          {"bv", SolverBackend::BitVector, 0U},
+          {"sat", SolverBackend::SAT, 0U}};
+}
+
+z3::solver
+SatEncoder::createSolver(z3::context&               ctx,
+                         const SolverConfiguration& configuration) {
+  z3::solver solver(ctx);
+  if (configuration.backend == SolverBackend::BitVector) {
+    solver = z3::tactic(ctx, "qfbv").mk_solver();
+  } else if (configuration.backend == SolverBackend::SAT) {
+    solver = (z3::tactic(ctx, "simplify") & z3::tactic(ctx, "bit-blast") &
+              z3::tactic(ctx, "sat"))
+                 .mk_solver();
+  }
+  z3::params params(ctx);
+  params.set("random_seed", configuration.seed);
+  solver.set(params);
+  return solver;
+}
+
+z3::check_result SatEncoder::checkPortfolio(const z3::solver& solver,
+                                            z3::model&        model) {
+  const auto nrOfConfigurations = portfolio.size();
+  // every configuration works on its own context (see Z3ContextPool). The
+  // instance is translated upfront since translation reads from the original
+  // context.
+  std::vector<std::unique_ptr<z3::context>> contexts{};
+  std::vector<z3::solver>                   solvers{};
+  contexts.reserve(nrOfConfigurations);
+  solvers.reserve(nrOfConfigurations);
+  for (const auto& configuration : portfolio) {
+    auto& ctx = *contexts.emplace_back(std::make_unique<z3::context>());
+    solvers.emplace_back(createSolver(ctx, configuration));
+    if (!applySolvingLimits(solvers.back())) {
+      stats.unknownReason = "timeout";
+      return z3::check_result::unknown;
+    }
+    const z3::expr_vector assertions(ctx, solver.assertions());
+    for (unsigned i = 0; i < assertions.size(); i++) {
+      solvers.back().add(assertions[i]);
+    }
+  }
+
+  std::mutex                    mutex;
+  std::condition_variable       cv;
+  std::size_t                   finished = 0U;
+  std::size_t                   winner   = nrOfConfigurations;
+  std::vector<z3::check_result> results(nrOfConfigurations,
+                                        z3::check_result::unknown);
+  std::vector<std::thread>      workers{};
+  workers.reserve(nrOfConfigurations);
+  for (std::size_t i = 0U; i < nrOfConfigurations; i++) {
+    workers.emplace_back([&, i]() {
+      auto result = z3::check_result::unknown;
+      try {
+        result = solvers[i].check();
+      } catch (const z3::exception&) {
+        // an interrupted configuration simply does not produce an answer
+      }
+      const std::lock_guard lock(mutex);
+      results[i] = result;
+      finished++;
+      if (result != z3::check_result::unknown && winner == nrOfConfigurations) {
+        winner = i;
+      }
+      cv.notify_one();
+    });
+  }
+
+  {
+    std::unique_lock lock(mutex);
+    cv.wait(lock, [&]() {
+      return winner != nrOfConfigurations || finished == nrOfConfigurations;
+    });
+    // an interrupt may be lost if a configuration has not entered check() yet,
+    // hence interrupt repeatedly until every configuration has returned
+    while (finished < nrOfConfigurations) {
+      for (std::size_t i = 0U; i < nrOfConfigurations; i++) {
+        if (i != winner) {
+          contexts[i]->interrupt();
+        }
+      }
+      cv.wait_for(lock, std::chrono::milliseconds(10),
+                  [&]() { return finished == nrOfConfigurations; });
+    }
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  if (winner == nrOfConfigurations) {
+    stats.solverConfiguration.clear();
+    stats.unknownReason = solvers.front().reason_unknown();
+    return z3::check_result::unknown;
+  }
+  stats.solverConfiguration = portfolio[winner].name;
+  recordZ3Statistics(solvers[winner].statistics());
+  if (results[winner] == z3::check_result::sat) {
+    auto winnerModel = solvers[winner].get_model();
+    model = z3::model(winnerModel, solver.ctx(), z3::model::translate{});
+  }
+  return results[winner];
+}
+
+std::size_t SatEncoder::encodingBitwidth() const {
+  auto bitwidth =
+      static_cast<std::size_t>(std::ceil(std::log2(generators.size())));
+  if (bitwidth < 1) {
+    bitwidth = 1;
+  }
+  return bitwidth;
+}
+
+void SatEncoder::extractCounterexample(
+    const z3::model&                         model,
+    const SatEncoder::CircuitRepresentation& circOneRep,
+    const SatEncoder::CircuitRepresentation& circTwoRep, unsigned bitwidth) {
+  auto&      ctx     = model.ctx();
+  const auto valueOf = [&](std::string_view prefix, std::size_t level) {
+    return static_cast<std::size_t>(
+        model
+            .eval(Z3ContextPool::variable(ctx, prefix, level, bitwidth), true)
+            .get_numeral_uint64());
+  };
+  const auto inputId     = valueOf("x^", 0U);
+  const auto outputOneId = valueOf("x^", circOneRep.generatorMappings.size());
+  const auto outputTwoId = valueOf("x'^", circTwoRep.generatorMappings.size());
+
+  const auto inputGenerator = materializeGenerator(circOneRep, inputId);
+  Counterexample result{};
+  result.input           = toInputString(inputGenerator);
+  result.inputGenerators = toPauliStrings(inputGenerator, stats.nrOfQubits);
+  result.outputGeneratorsOne = toPauliStrings(
+      materializeGenerator(circOneRep, outputOneId), stats.nrOfQubits);
+  result.outputGeneratorsTwo = toPauliStrings(
+      materializeGenerator(circTwoRep, outputTwoId), stats.nrOfQubits);
+  for (std::size_t i = 0U; i < result.outputGeneratorsOne.size() &&
+                           i < result.outputGeneratorsTwo.size();
+       i++) {
+    if (result.outputGeneratorsOne[i] != result.outputGeneratorsTwo[i]) {
+      result.differingGenerators.emplace_back(i);
+    }
+  }
+  counterexample = result;
+}
+
+std::vector<std::string>
+SatEncoder::toPauliStrings(const std::vector<std::vector<bool>>& generator,
+                           std::size_t                           nrOfQubits) {
+  const auto n           = nrOfQubits;
+  const auto pauliLetter = [n](const std::vector<bool>& row,
+                               std::size_t offset, std::size_t j) {
+    if (row[offset + j] && row[offset + n + j]) {
+      return 'Y';
+    }
+    if (row[offset + j]) {
+      return 'X';
+    }
+    return row[offset + n + j] ? 'Z' : 'I';
+  };
+  std::vector<std::string> result{};
+  for (const auto& row : generator) {
+    std::string pauli{};
+    if (row.size() == 2U * n + 1U) {
+      pauli += row[2U * n] ? '-' : '+';
+      for (std::size_t j = 0U; j < n; j++) {
+        pauli += pauliLetter(row, 0U, j);
+      }
+      result.emplace_back(pauli);
+      continue;
+    }
+    // Pauli sum, see QState::getLevelGenerator
+    const auto termSize = 2U * n + Coefficient::BITS;
+    for (std::size_t offset = 0U; offset + termSize <= row.size();
+         offset += termSize) {
+      Coefficient coefficient{0, 0, 0U};
+      for (std::size_t bit = 0U; bit < 64U; bit++) {
+        const auto base = offset + 2U * n;
+        coefficient.a |= static_cast<std::int64_t>(row[base + bit]) << bit;
+        coefficient.b |= static_cast<std::int64_t>(row[base + 64U + bit])
+                         << bit;
+        if (bit < 8U) {
+          coefficient.k |= static_cast<std::uint8_t>(
+              static_cast<unsigned>(row[base + 128U + bit]) << bit);
+        }
+      }
+      std::stringstream ss{};
+      ss << std::showpos << std::setprecision(4) << coefficient.toDouble();
+      pauli += ss.str();
+      for (std::size_t j = 0U; j < n; j++) {
+        pauli += pauliLetter(row, offset, j);
+      }
+    }
+    result.emplace_back(pauli);
+  }
+  return result;
+}
+
+std::string
+SatEncoder::toInputString(const std::vector<std::vector<bool>>& generator) {
+  // inverse of the encoding in initializeState: row i has to be a single-qubit
+  // Pauli on qubit i, lower case letters denote the +1 eigenstates
+  std::string input{};
+  const auto  pauliStrings = toPauliStrings(
+      generator,
+      generator.empty() ? 0U : (generator.front().size() - 1U) / 2U);
+  if (pauliStrings.size() == 1U && pauliStrings.front().size() > 2U) {
+    // a propagated single-qubit Pauli operator P_i distinguishes the circuits
+    // for the state that is stabilized by P_i and Z on all other qubits
+    const auto& pauli = pauliStrings.front();
+    input             = std::string(pauli.size() - 1U, 'z');
+    std::size_t nrOfNonTrivial = 0U;
+    for (std::size_t j = 1U; j < pauli.size(); j++) {
+      if (pauli[j] != 'I') {
+        nrOfNonTrivial++;
+        const auto letter = static_cast<char>(pauli[j] - 'A' + 'a');
+        input[j - 1U] = pauli[0] == '-' ? pauli[j] : letter;
+      }
+    }
+    return nrOfNonTrivial == 1U ? input : std::string{};
+  }
+  for (std::size_t i = 0U; i < pauliStrings.size(); i++) {
+    const auto& pauli = pauliStrings[i];
+    for (std::size_t j = 1U; j < pauli.size(); j++) {
+      if ((pauli[j] != 'I') != (j == i + 1U)) {
+        return {};
+      }
+    }
+    if (i + 1U >= pauli.size()) {
+      return {};
+    }
+    const auto negative = pauli[0] == '-';
+    switch (pauli[i + 1U]) {
+    case 'X':
+      input += negative ? 'X' : 'x';
+      break;
+    case 'Y':
+      input += negative ? 'Y' : 'y';
+      break;
+    default:
+      input += negative ? 'Z' : 'z';
+      break;
+    }
+  }
+  return input;
+}
+
+SatEncoder::CircuitRepresentation
+SatEncoder::obtainRepresentation(const CliffordCircuit&          circuit,
+                                 const std::vector<std::string>& inputs,
+                                 bool storeGenerators) {
+  const auto  restricted = restrictAncillas(inputs, {&circuit});
+  std::string key{};
+  if (cache != nullptr) {
+    key = EncodingCache::key(circuit, restricted);
+    if (const auto encoding =
+            cache->find(key, EncodingCache::content(circuit, restricted))) {
+      stats.cacheHits++;
+      return importEncoding(*encoding);
+    }
+  }
+  auto representation = preprocessCircuit(circuit, restricted,
+                                          storeGenerators || cache != nullptr);
+  if (cache != nullptr && stats.unknownReason.empty()) {
+    cache->insert(key, exportEncoding(representation, circuit, restricted));
+  }
+  return representation;
+}
+
+CachedEncoding SatEncoder::exportEncoding(
+    const SatEncoder::CircuitRepresentation& representation,
+    const CliffordCircuit& circuit, const std::vector<std::string>& inputs) {
+  CachedEncoding encoding{};
+  encoding.nrOfQubits = circuit.nrOfQubits;
+  encoding.inputHash  = EncodingCache::hash(inputs);
+  encoding.nrOfGates  = representation.nrOfGates;
+  encoding.content    = EncodingCache::content(circuit, inputs);
+  encoding.generatorMappings.resize(representation.generatorMappings.size());
+
+  // input generators are numbered first, such that they are also inserted
+  // first when the encoding is imported again
+  std::map<std::size_t, std::size_t> localIds{};
+  const auto                         localId = [&](std::size_t id) {
+    const auto [it, inserted] = localIds.emplace(id, localIds.size());
+    if (inserted) {
+      encoding.generators.emplace_back(representation.idGeneratorMap.at(id));
+    }
+    return it->second;
+  };
+  for (const auto id : representation.inputGeneratorIds) {
+    encoding.inputGeneratorIds.emplace_back(localId(id));
+  }
+  for (std::size_t i = 0U; i < representation.generatorMappings.size(); i++) {
+    for (const auto& [from, to] : representation.generatorMappings[i]) {
+      const auto localFrom = localId(from);
+      encoding.generatorMappings[i].emplace(localFrom, localId(to));
+    }
+  }
+  return encoding;
+}
+
+template <class Encoding>
+SatEncoder::CircuitRepresentation
+SatEncoder::importEncoding(const Encoding& encoding) {
+  auto before = std::chrono::high_resolution_clock::now();
+  SatEncoder::CircuitRepresentation representation;
+  const auto  inputGeneratorIds = inputGeneratorIdsOf(encoding);
+  std::size_t nrOfLocalInputs   = 0U;
+  for (const auto id : inputGeneratorIds) {
+    nrOfLocalInputs = std::max(nrOfLocalInputs, id + 1U);
+  }
+
+  std::vector<std::size_t> ids(nrOfGenerators(encoding));
+  for (std::size_t i = 0U; i < ids.size(); i++) {
+    const auto& generator   = generatorOf(encoding, i);
+    const auto  materialize = [&generator]() { return generator; };
+    ids[i] = findOrInsertGenerator(fingerprintOf(generator), materialize).first;
+    representation.idGeneratorMap.emplace(ids[i], generator);
+    if (i + 1U == nrOfLocalInputs &&
+        nrOfInputGenerators == 0) { // only in first pass
+      nrOfInputGenerators = uniqueGenCnt;
+    }
+  }
+  for (const auto id : inputGeneratorIds) {
+    representation.inputGeneratorIds.emplace_back(ids.at(id));
+  }
+  const auto depth = nrOfLevels(encoding);
+  representation.generatorMappings.resize(depth);
+  for (std::size_t i = 0U; i < depth; i++) {
+    forEachMapping(encoding, i, [&](std::size_t from, std::size_t to) {
+      representation.generatorMappings[i].emplace(ids.at(from), ids.at(to));
+    });
+  }
+  representation.nrOfGates = nrOfGatesOf(encoding);
+  stats.nrOfGates += representation.nrOfGates;
+  stats.circuitDepth = std::max(stats.circuitDepth, depth);
+
+  auto after = std::chrono::high_resolution_clock::now();
+  stats.preprocTime +=
+      std::chrono::duration_cast<std::chrono::milliseconds>(after - before)
+          .count();
+  return representation;
 }
 
 SatEncoder::CircuitRepresentation
-SatEncoder::preprocessCircuit(const qc::DAG&                  dag,
-                              const std::vector<std::string>& inputs) {
+SatEncoder::preprocessCircuit(const CliffordCircuit&          circuit,
+                              const std::vector<std::string>& inputs,
+                              bool storeGenerators, bool incrementalCheck) {
   auto                before     = std::chrono::high_resolution_clock::now();
-  std::size_t         inputSize  = dag.size();
   std::size_t         nrOfLevels = 0;
-  std::size_t         nrOfOpsOnQubit = 0;
   std::vector<QState> states;
   SatEncoder::CircuitRepresentation representation;
-  unsigned long                     nrOfQubits = dag.size();
+  unsigned long                     nrOfQubits = circuit.nrOfQubits;
+  representation.circuit                       = circuit;
+  representation.inputs                        = inputs;
 
+  const auto gatesOnQubit = gatesPerQubit(circuit);
   // compute nr of levels of ckt = #generators needed per input state
-  std::size_t tmp;
-  for (std::size_t i = 0U; i < inputSize; i++) {
-    tmp = dag.at(i).size();
-    if (tmp > nrOfLevels) {
-      nrOfLevels = tmp;
+  nrOfLevels = nrOfLevelsOf(circuit, gatesOnQubit);
+
+  stats.circuitDepth =
+      nrOfLevels > stats.circuitDepth ? nrOfLevels : stats.circuitDepth;
+  representation.generatorMappings =
+      std::vector<std::map<std::size_t, std::size_t>>(nrOfLevels);
+  representation.checkpointInterval = checkpointInterval;
+  if (checkpointInterval == 0U && incrementalCheck) {
+    // resuming from a checkpoint and storing all checkpoints both take about
+    // sqrt(depth) levels worth of work and memory
+    representation.checkpointInterval = std::max<std::size_t>(
+        static_cast<std::size_t>(
+            std::ceil(std::sqrt(static_cast<double>(nrOfLevels)))),
+        1U);
+  }
+
+  if (!inputs.empty()) {
+    for (auto& input : inputs) {
+      states.push_back(initializeState(nrOfQubits, input));
+    }
+  } else {
+    states.push_back(initializeState(nrOfQubits, {}));
+  }
+  simulateStates(states, circuit, gatesOnQubit, storeGenerators,
+                 representation, 0U);
+  stats.nrOfGates       += representation.nrOfGates;
+  stats.nrOfCheckpoints += representation.checkpoints.size();
+  auto after = std::chrono::high_resolution_clock::now();
+  stats.preprocTime +=
+      std::chrono::duration_cast<std::chrono::milliseconds>(after - before)
+          .count();
+  return representation;
+}
+
+std::size_t SatEncoder::resumePreprocessing(
+    SatEncoder::CircuitRepresentation& representation,
+    const CliffordCircuit& circuit, std::size_t firstLevel) {
+  auto  before           = std::chrono::high_resolution_clock::now();
+  auto& checkpoints      = representation.checkpoints;
+  representation.circuit = circuit;
+
+  const auto gatesOnQubit = gatesPerQubit(circuit);
+  const auto nrOfLevels   = nrOfLevelsOf(circuit, gatesOnQubit);
+  stats.circuitDepth      = std::max(stats.circuitDepth, nrOfLevels);
+
+  // closest checkpoint at or before the first affected level, the later ones
+  // are captured again
+  std::size_t         start = 0U;
+  std::vector<QState> states{};
+  auto                it = checkpoints.upper_bound(firstLevel);
+  for (auto later = it; later != checkpoints.end(); ++later) {
+    representation.checkpointBytes -= later->second.bytes;
+  }
+  checkpoints.erase(it, checkpoints.end());
+  if (!checkpoints.empty()) {
+    start = checkpoints.rbegin()->first;
+    for (const auto& state : checkpoints.rbegin()->second.states) {
+      states.emplace_back(state.unpack());
+    }
+  } else {
+    representation.inputGeneratorIds.clear();
+    const auto& inputs = representation.inputs;
+    if (!inputs.empty()) {
+      for (const auto& input : inputs) {
+        states.push_back(initializeState(circuit.nrOfQubits, input));
+      }
+    } else {
+      states.push_back(initializeState(circuit.nrOfQubits, {}));
+    }
+  }
+  representation.generatorMappings.resize(start);
+  representation.generatorMappings.resize(nrOfLevels);
+  representation.nrOfGates = 0U;
+  for (const auto& gates : gatesOnQubit) {
+    representation.nrOfGates += std::min(gates.size(), start);
+  }
+  simulateStates(states, circuit, gatesOnQubit, false, representation, start);
+  stats.nrOfGates       += representation.nrOfGates;
+  stats.nrOfCheckpoints += representation.checkpoints.size();
+  auto after = std::chrono::high_resolution_clock::now();
+  stats.preprocTime +=
+      std::chrono::duration_cast<std::chrono::milliseconds>(after - before)
+          .count();
+  return nrOfLevels - start;
+}
+
+std::size_t SatEncoder::firstAffectedLevel(const CliffordCircuit& circuit,
+                                           const CliffordCircuit& edited,
+                                           const CircuitEdit&     edit) {
+  const auto forQubits = [](const CliffordGate& gate, auto&& visit) {
+    if (gate.control >= 0) {
+      visit(static_cast<std::size_t>(gate.control));
+    }
+    visit(static_cast<std::size_t>(gate.target));
+  };
+  // the levels of a qubit are the gates acting on it in order. Only the
+  // qubits of replaced or inserted gates change their sequence of gates, and
+  // only after the gates before the edit
+  std::vector<std::size_t> depthOne(circuit.nrOfQubits);
+  std::vector<std::size_t> depthTwo(edited.nrOfQubits);
+  std::vector<std::size_t> gatesBefore(circuit.nrOfQubits);
+  for (std::size_t i = 0U; i < circuit.nrOfGates; i++) {
+    forQubits(circuit.gates[i], [&](std::size_t qubit) {
+      depthOne[qubit]++;
+      if (i < edit.begin) {
+        gatesBefore[qubit]++;
+      }
+    });
+  }
+  for (const auto& gate : edited) {
+    forQubits(gate, [&](std::size_t qubit) { depthTwo[qubit]++; });
+  }
+  auto       level   = std::numeric_limits<std::size_t>::max();
+  const auto touches = [&](std::size_t qubit) {
+    level = std::min(level, gatesBefore[qubit]);
+  };
+  for (std::size_t i = edit.begin; i < edit.end; i++) {
+    forQubits(circuit.gates[i], touches);
+  }
+  for (const auto& gate : edit.gates) {
+    forQubits(gate, touches);
+  }
+  const auto oldDepth = *std::max_element(depthOne.begin(), depthOne.end());
+  const auto newDepth = *std::max_element(depthTwo.begin(), depthTwo.end());
+  level               = std::min({level, oldDepth, newDepth});
+  // the output permutation is applied together with the last level
+  if (circuit.outputPermutation != nullptr && oldDepth != newDepth) {
+    level = std::min(level, std::min(oldDepth, newDepth) - 1U);
+  }
+  return level;
+}
+
+template <class State>
+void SatEncoder::simulate(
+    std::vector<State>& states, const CliffordCircuit& circuit,
+    const std::vector<std::vector<std::size_t>>& gatesOnQubit,
+    bool storeGenerators, SatEncoder::CircuitRepresentation& representation,
+    std::size_t firstLevel) {
+  const auto nrOfQubits = circuit.nrOfQubits;
+  const auto nrOfLevels = representation.generatorMappings.size();
+
+  // estimated number of bytes needed to store one generator in the generator
+  // table and, if materialized, in the representation
+  std::size_t generatorMemory = sizeof(Fingerprint) + 4U * sizeof(void*);
+  if (storeGenerators || verifyGenerators) {
+    generatorMemory +=
+        2U * nrOfQubits *
+        (sizeof(std::vector<bool>) + (2U * nrOfQubits + 1U + 7U) / 8U);
+  }
+  const auto idOf = [&](const State& state) {
+    const auto [id, inserted] = findOrInsertGenerator(
+        state.fingerprint(), [&state]() { return state.getLevelGenerator(); });
+    if (inserted) {
+      preprocMemory += generatorMemory;
+    }
+    if (storeGenerators && representation.idGeneratorMap.count(id) == 0U) {
+      representation.idGeneratorMap.emplace(id, state.getLevelGenerator());
+    }
+    return id;
+  };
+
+  // store generators of input state
+  if (firstLevel == 0U) {
+    for (auto& state : states) {
+      const auto id = idOf(state);
+      representation.inputGeneratorIds.emplace_back(id);
+      state.prevGenId = id;
+    }
+  }
+
+  if (nrOfInputGenerators == 0) { // only in first pass
+    nrOfInputGenerators = uniqueGenCnt;
+  }
+
+  for (std::size_t levelCnt = firstLevel; levelCnt < nrOfLevels; levelCnt++) {
+    if (representation.checkpointInterval != 0U && levelCnt != 0U &&
+        levelCnt != firstLevel &&
+        levelCnt % representation.checkpointInterval == 0U) {
+      addCheckpoint(representation, levelCnt, states);
+    }
+    representation.nrOfGates +=
+        applyLevel(states, circuit, gatesOnQubit, levelCnt,
+                   levelCnt + 1U == nrOfLevels);
+    for (auto& state : states) {
+      const auto id = idOf(state);
+      representation.generatorMappings.at(levelCnt).emplace(state.prevGenId,
+                                                            id);
+      state.prevGenId = id;
+    }
+    // each mapping is a node in a std::map
+    preprocMemory += states.size() * 4U * sizeof(std::size_t);
+    if (preprocessingBudgetExceeded()) {
+      break;
+    }
+  }
+}
+
+template <class State>
+void SatEncoder::addCheckpoint(
+    SatEncoder::CircuitRepresentation& representation, std::size_t level,
+    const std::vector<State>& states) {
+  auto& checkpoint = representation.checkpoints[level];
+  for (const auto& state : states) {
+    if constexpr (std::is_same_v<State, QState>) {
+      checkpoint.states.emplace_back(state);
+    } else {
+      checkpoint.states.emplace_back(state.toQState());
+    }
+    checkpoint.bytes += checkpoint.states.back().bytes();
+  }
+  representation.checkpointBytes += checkpoint.bytes;
+  preprocMemory += checkpoint.bytes;
+
+  // doubling the interval keeps the checkpoints evenly spaced. A single
+  // checkpoint above the limit removes all of them
+  const auto limit       = checkpointMemory * 1024U * 1024U;
+  auto&      checkpoints = representation.checkpoints;
+  while (checkpointMemory != 0U && representation.checkpointBytes > limit) {
+    representation.checkpointInterval *= 2U;
+    for (auto it = checkpoints.begin(); it != checkpoints.end();) {
+      if (it->first % representation.checkpointInterval == 0U) {
+        ++it;
+        continue;
+      }
+      representation.checkpointBytes -= it->second.bytes;
+      preprocMemory -= std::min(preprocMemory, it->second.bytes);
+      it = checkpoints.erase(it);
+    }
+  }
+}
+
+void SatEncoder::simulateStates(
+    std::vector<QState>& states, const CliffordCircuit& circuit,
+    const std::vector<std::vector<std::size_t>>& gatesOnQubit,
+    bool storeGenerators, SatEncoder::CircuitRepresentation& representation,
+    std::size_t firstLevel) {
+  const auto nrOfQubits = circuit.nrOfQubits;
+  const auto cliffordOnly =
+      std::none_of(circuit.begin(), circuit.end(), [](const auto& gate) {
+        return gate.type == static_cast<std::uint8_t>(GateType::T) ||
+               gate.type == static_cast<std::uint8_t>(GateType::Tdg);
+      });
+  if (cliffordOnly && nrOfQubits <= FixedQState<1U>::MAX_QUBITS) {
+    std::vector<FixedQState<1U>> fixed(states.begin(), states.end());
+    simulate(fixed, circuit, gatesOnQubit, storeGenerators, representation,
+             firstLevel);
+  } else if (cliffordOnly && nrOfQubits <= FixedQState<2U>::MAX_QUBITS) {
+    std::vector<FixedQState<2U>> fixed(states.begin(), states.end());
+    simulate(fixed, circuit, gatesOnQubit, storeGenerators, representation,
+             firstLevel);
+  } else if (cliffordOnly && nrOfQubits <= FixedQState<4U>::MAX_QUBITS) {
+    std::vector<FixedQState<4U>> fixed(states.begin(), states.end());
+    simulate(fixed, circuit, gatesOnQubit, storeGenerators, representation,
+             firstLevel);
+  } else {
+    simulate(states, circuit, gatesOnQubit, storeGenerators, representation,
+             firstLevel);
+  }
+}
+
+std::vector<std::vector<std::size_t>>
+SatEncoder::gatesPerQubit(const CliffordCircuit& circuit) {
+  std::vector<std::vector<std::size_t>> gatesOnQubit(circuit.nrOfQubits);
+  for (std::size_t i = 0U; i < circuit.nrOfGates; i++) {
+    const auto& gate = circuit.gates[i];
+    if (gate.control >= 0) {
+      gatesOnQubit[static_cast<std::size_t>(gate.control)].emplace_back(i);
+    }
+    gatesOnQubit[static_cast<std::size_t>(gate.target)].emplace_back(i);
+  }
+  return gatesOnQubit;
+}
+
+std::size_t SatEncoder::nrOfLevelsOf(
+    const CliffordCircuit&                       circuit,
+    const std::vector<std::vector<std::size_t>>& gatesOnQubit) {
+  std::size_t nrOfLevels = 0U;
+  for (const auto& gates : gatesOnQubit) {
+    nrOfLevels = std::max(nrOfLevels, gates.size());
+  }
+  if (nrOfLevels == 0U && circuit.outputPermutation != nullptr) {
+    return 1U;
+  }
+  return nrOfLevels;
+}
+
+template <class State>
+std::size_t SatEncoder::applyLevel(
+    std::vector<State>& states, const CliffordCircuit& circuit,
+    const std::vector<std::vector<std::size_t>>& gatesOnQubit,
+    std::size_t level, bool lastLevel) {
+  std::size_t nrOfGates = 0U;
+  for (std::size_t qubitCnt = 0U; qubitCnt < gatesOnQubit.size();
+       qubitCnt++) { // operation of current level for each qubit
+    if (level >= gatesOnQubit[qubitCnt].size()) {
+      continue;
+    }
+    nrOfGates++;
+    const auto& gate   = circuit.gates[gatesOnQubit[qubitCnt][level]];
+    const auto  target = static_cast<unsigned long>(gate.target);
+
+    for (auto& currState : states) {
+      switch (static_cast<GateType>(gate.type)) {
+      case GateType::H:
+        currState.applyH(target);
+        break;
+      case GateType::S:
+        currState.applyS(target);
+        break;
+      case GateType::Sdg:
+        currState.applyS(target); // Sdag == SSS
+        currState.applyS(target);
+        currState.applyS(target);
+        break;
+      case GateType::Z:
+        currState.applyH(target);
+        currState.applyS(target);
+        currState.applyS(target);
+        currState.applyH(target);
+        break;
+      case GateType::X:
+        if (gate.control < 0) {
+          currState.applyH(target);
+          currState.applyS(target);
+          currState.applyS(target);
+        } else if (qubitCnt == static_cast<std::size_t>(gate.control)) {
+          // CNOT is for control and target, only apply if current qubit is
+          // control
+          currState.applyCNOT(static_cast<unsigned long>(gate.control),
+                              target);
+        }
+        break;
+      case GateType::Y:
+        currState.applyH(target);
+        currState.applyS(target);
+        currState.applyS(target);
+        currState.applyS(target);
+        break;
+      case GateType::T:
+      case GateType::Tdg:
+        // bit-sliced states are only used for circuits without T gates
+        if constexpr (std::is_same_v<State, QState>) {
+          currState.applyT(target, gate.type == static_cast<std::uint8_t>(
+                                                    GateType::Tdg));
+        }
+        break;
+      default:
+        break;
+      }
+    }
+  }
+  if (lastLevel && circuit.outputPermutation != nullptr) {
+    for (auto& state : states) {
+      state.permuteColumns(circuit.outputPermutation);
+    }
+  }
+  return nrOfGates;
+}
+
+CliffordCircuit SatEncoder::withWidth(const CliffordCircuit& circuit,
+                                      std::size_t            nrOfQubits,
+                                      CircuitLayout&         storage) {
+  if (circuit.nrOfQubits >= nrOfQubits) {
+    return circuit;
+  }
+  storage.outputPermutation.resize(nrOfQubits);
+  storage.ancillary.resize(nrOfQubits);
+  for (std::size_t i = 0U; i < nrOfQubits; i++) {
+    const auto original = i < circuit.nrOfQubits;
+    storage.outputPermutation[i] =
+        original && circuit.outputPermutation != nullptr
+            ? circuit.outputPermutation[i]
+            : static_cast<std::uint32_t>(i);
+    storage.ancillary[i] = 1U;
+    if (original) {
+      storage.ancillary[i] =
+          circuit.ancillary != nullptr ? circuit.ancillary[i] : 0U;
+    }
+  }
+  auto result              = circuit;
+  result.nrOfQubits        = nrOfQubits;
+  result.outputPermutation = storage.outputPermutation.data();
+  result.ancillary         = storage.ancillary.data();
+  return result;
+}
+
+std::vector<std::string> SatEncoder::restrictAncillas(
+    const std::vector<std::string>&            inputs,
+    const std::vector<const CliffordCircuit*>& circuits) {
+  const auto isAncilla = [&circuits](std::size_t qubit) {
+    return std::any_of(circuits.begin(), circuits.end(),
+                       [qubit](const CliffordCircuit* circuit) {
+                         return circuit->ancillary != nullptr &&
+                                qubit < circuit->nrOfQubits &&
+                                circuit->ancillary[qubit] != 0U;
+                       });
+  };
+  std::vector<std::string> result{};
+  for (auto input : inputs) {
+    if (!input.empty() && (input.front() == '+' || input.front() == '-')) {
+      // operators with X or Y on an ancilla do not stabilize |0> there and
+      // are dropped, only Z is propagated on ancillas
+      bool stabilizesZero = true;
+      for (std::size_t i = 1U; i < input.size(); i++) {
+        if ((input[i] == 'X' || input[i] == 'Y') && isAncilla(i - 1U)) {
+          stabilizesZero = false;
+        }
+      }
+      if (stabilizesZero) {
+        result.emplace_back(std::move(input));
+      }
+      continue;
+    }
+    for (std::size_t i = 0U; i < input.size(); i++) {
+      if (isAncilla(i)) {
+        input[i] = 'z';
+      }
     }
+    result.emplace_back(std::move(input));
   }
+  return result;
+}
 
-  stats.circuitDepth =
-      nrOfLevels > stats.circuitDepth ? nrOfLevels : stats.circuitDepth;
-  representation.generatorMappings =
-      std::vector<std::map<std::size_t, std::size_t>>(nrOfLevels);
-
-  if (!inputs.empty()) {
-    for (auto& input : inputs) {
-      states.push_back(initializeState(nrOfQubits, input));
+template <class Materialize>
+std::pair<std::size_t, bool>
+SatEncoder::findOrInsertGenerator(const Fingerprint& fingerprint,
+                                  Materialize&&      materialize) {
+  const auto [begin, end] = generators.equal_range(fingerprint);
+  if (!verifyGenerators) {
+    if (begin != end) {
+      return {begin->second, false};
     }
-  } else {
-    states.push_back(initializeState(nrOfQubits, {}));
+    generators.emplace(fingerprint, uniqueGenCnt);
+    return {uniqueGenCnt++, true};
   }
-
-  // store generators of input state
-  for (auto& state : states) {
-    auto        initLevelGenerator = state.getLevelGenerator();
-    auto        inspair = generators.emplace(initLevelGenerator, uniqueGenCnt);
-    std::size_t id;
-    if (inspair.second) {
-      id = uniqueGenCnt++;
-    } else {
-      id = generators.at(initLevelGenerator);
+  auto generator = materialize();
+  for (auto it = begin; it != end; ++it) {
+    if (generatorContents.at(it->second) == generator) {
+      return {it->second, false};
     }
-    representation.idGeneratorMap.emplace(id, initLevelGenerator);
-    state.prevGenId = id;
   }
+  // new generator or a collision of fingerprints
+  generators.emplace(fingerprint, uniqueGenCnt);
+  generatorContents.emplace_back(std::move(generator));
+  return {uniqueGenCnt++, true};
+}
 
-  if (nrOfInputGenerators == 0) { // only in first pass
-    nrOfInputGenerators = uniqueGenCnt;
+std::vector<std::vector<bool>> SatEncoder::materializeGenerator(
+    const SatEncoder::CircuitRepresentation& representation,
+    std::size_t                              id) const {
+  if (const auto it = representation.idGeneratorMap.find(id);
+      it != representation.idGeneratorMap.end()) {
+    return it->second;
   }
-
-  for (std::size_t levelCnt = 0; levelCnt < nrOfLevels; levelCnt++) {
-    for (std::size_t qubitCnt = 0U; qubitCnt < inputSize;
-         qubitCnt++) { // operation of current level for each qubit
-      nrOfOpsOnQubit = dag.at(qubitCnt).size();
-
-      if (levelCnt < nrOfOpsOnQubit) {
-        if (!dag.at(qubitCnt).empty() &&
-            dag.at(qubitCnt).at(levelCnt) != nullptr) {
-          stats.nrOfGates++;
-          auto       gate = dag.at(qubitCnt).at(levelCnt)->get();
-          const auto target =
-              gate->getTargets().at(0U); // we assume we only have 1 target
-
-          for (auto& currState : states) {
-            if (gate->getType() == qc::OpType::H) {
-              currState.applyH(target);
-            } else if (gate->getType() == qc::OpType::S) {
-              currState.applyS(target);
-            } else if (gate->getType() == qc::OpType::Sdg) {
-              currState.applyS(target); // Sdag == SSS
-              currState.applyS(target);
-              currState.applyS(target);
-            } else if (gate->getType() == qc::OpType::Z) {
-              currState.applyH(target);
-              currState.applyS(target);
-              currState.applyS(target);
-              currState.applyH(target);
-            } else if (gate->getType() == qc::OpType::X &&
-                       !gate->isControlled()) {
-              currState.applyH(target);
-              currState.applyS(target);
-              currState.applyS(target);
-            } else if (gate->getType() == qc::OpType::Y) {
-              currState.applyH(target);
-              currState.applyS(target);
-              currState.applyS(target);
-              currState.applyS(target);
-            } else if (gate->isControlled() &&
-                       gate->getType() == qc::OpType::X) { // CNOT
-              const auto control =
-                  gate->getControls()
-                      .begin()
-                      ->qubit; // we assume we only have 1 control
-              if (qubitCnt ==
-                  control) { // CNOT is for control and target in DAG, only
-                             // apply if current qubit is control
-                currState.applyCNOT(control, target);
-              }
-            }
-          }
-        }
+  if (id < generatorContents.size()) {
+    return generatorContents[id];
+  }
+  // find an input state whose chain of generators contains the id and
+  // simulate it up to the respective level
+  const auto& mappings = representation.generatorMappings;
+  for (std::size_t i = 0U; i < representation.inputGeneratorIds.size(); i++) {
+    auto        current = representation.inputGeneratorIds[i];
+    std::size_t levels  = 0U;
+    while (current != id && levels < mappings.size()) {
+      const auto next = mappings[levels].find(current);
+      if (next == mappings[levels].end()) {
+        break;
       }
+      current = next->second;
+      levels++;
     }
-    for (auto& state : states) {
-      auto        currLevelGen = state.getLevelGenerator();
-      auto        inspair      = generators.emplace(currLevelGen, uniqueGenCnt);
-      std::size_t id;
-      if (inspair.second) {
-        id = uniqueGenCnt;
-        uniqueGenCnt++;
-      } else {
-        id = generators.at(currLevelGen);
-      }
-      representation.idGeneratorMap.emplace(id, currLevelGen);
-      representation.generatorMappings.at(levelCnt).emplace(state.prevGenId,
-                                                            id);
-      state.prevGenId = id;
+    if (current != id) {
+      continue;
+    }
+    // closest checkpoint at or before the level of the generator
+    std::vector<QState> states{};
+    std::size_t         first       = 0U;
+    const auto&         checkpoints = representation.checkpoints;
+    if (auto it = checkpoints.upper_bound(levels); it != checkpoints.begin()) {
+      --it;
+      first = it->first;
+      states.emplace_back(it->second.states.at(i).unpack());
+    } else {
+      const auto& inputs = representation.inputs;
+      states.emplace_back(
+          initializeState(representation.circuit.nrOfQubits,
+                          inputs.empty() ? std::string{} : inputs.at(i)));
+    }
+    const auto gatesOnQubit = gatesPerQubit(representation.circuit);
+    for (std::size_t level = first; level < levels; level++) {
+      applyLevel(states, representation.circuit, gatesOnQubit, level,
+                 level + 1U == mappings.size());
     }
+    return states.front().getLevelGenerator();
   }
-  auto after = std::chrono::high_resolution_clock::now();
-  stats.preprocTime +=
-      std::chrono::duration_cast<std::chrono::milliseconds>(after - before)
-          .count();
-  return representation;
+  throw std::logic_error("Generator " + std::to_string(id) +
+                         " cannot be materialized");
 }
 
 // construct z3 instance from preprocessing information
 void SatEncoder::constructSatInstance(
     const SatEncoder::CircuitRepresentation& circuitRepresentation,
-    z3::solver&                              solver) {
+    Z3ContextPool::Lease& z3, z3::solver& solver) {
   auto before = std::chrono::high_resolution_clock::now();
   // number of unique generators that need to be encoded
   const auto generatorCnt = generators.size();
@@ -234,46 +1470,27 @@ void SatEncoder::constructSatInstance(
       std::log2(generatorCnt) < static_cast<double>(bitwidth);
 
   // z3 context used throughout this function
-  auto& ctx = solver.ctx();
+  auto&      ctx   = z3.ctx();
+  const auto width = static_cast<unsigned>(bitwidth);
 
   const auto depth = circuitRepresentation.generatorMappings.size();
 
   std::vector<z3::expr> vars{};
   vars.reserve(depth + 1U);
-  std::string bvName = "x^";
 
   for (std::size_t k = 0U; k <= depth; k++) {
     // create bitvector [x^k]_2 with respective bitwidth for each level k of ckt
-    std::stringstream ss{};
-    ss << bvName << k; //
-    vars.emplace_back(ctx.bv_const(ss.str().c_str(), bitwidth));
+    vars.emplace_back(Z3ContextPool::variable(ctx, "x^", k, width));
     stats.nrOfSatVars++;
   }
 
-  for (std::size_t i = 0U; i < depth; i++) {
-    const auto layer = circuitRepresentation.generatorMappings.at(
-        i); // generator<>generator map for level i
-    for (const auto& [from, to] : layer) {
-      const auto g1 =
-          generators.at(circuitRepresentation.idGeneratorMap.at(from));
-      const auto g2 =
-          generators.at(circuitRepresentation.idGeneratorMap.at(to));
-
-      // create [x^l]_2 = i => [x^l']_2 = k for each generator mapping
-      const auto left =
-          vars[i] == ctx.bv_val(static_cast<std::uint64_t>(g1), bitwidth);
-      const auto right =
-          vars[i + 1U] == ctx.bv_val(static_cast<std::uint64_t>(g2), bitwidth);
-      const auto cons = implies(left, right);
-      solver.add(cons);
-      stats.nrOfFunctionalConstr++;
-    }
-  }
+  // create [x^l]_2 = i => [x^l']_2 = k for each generator mapping
+  addMappingConstraints({&circuitRepresentation}, {"x^"}, false, width, z3,
+                        solver);
 
   if (blockingConstraintsNeeded) {
     for (const auto& var : vars) {
-      const auto cons = ult(
-          var, ctx.bv_val(static_cast<std::uint64_t>(generatorCnt), bitwidth));
+      const auto cons = ult(var, z3.value(generatorCnt, width));
       solver.add(cons); // [x^l]_2 < m
     }
   }
@@ -285,7 +1502,8 @@ void SatEncoder::constructSatInstance(
 
 void SatEncoder::constructMiterInstance(
     const SatEncoder::CircuitRepresentation& circOneRep,
-    const SatEncoder::CircuitRepresentation& circTwoRep, z3::solver& solver) {
+    const SatEncoder::CircuitRepresentation& circTwoRep,
+    Z3ContextPool::Lease& z3, z3::solver& solver) {
   auto before = std::chrono::high_resolution_clock::now();
   // number of unique generators that need to be encoded
   const auto generatorCnt = generators.size();
@@ -304,85 +1522,45 @@ void SatEncoder::constructMiterInstance(
   bool blockingConstraintsNeeded =
       std::log2(generatorCnt) < static_cast<double>(bitwidth);
   // z3 context used throughout this function
-  auto& ctx = solver.ctx();
+  auto&      ctx   = z3.ctx();
+  const auto width = static_cast<unsigned>(bitwidth);
 
   /// encode first circuit
   const auto            depthOne = circOneRep.generatorMappings.size();
   std::vector<z3::expr> varsOne{};
   varsOne.reserve(depthOne + 1U);
-  std::string bvName = "x^";
 
   for (std::size_t k = 0U; k <= depthOne; k++) {
     // create bitvector [x^k]_2 with respective bitwidth for each level k of ckt
-    std::stringstream ss{};
-    ss << bvName << k; //
-    const auto tmp = ctx.bv_const(ss.str().c_str(), bitwidth);
-    varsOne.emplace_back(tmp);
+    varsOne.emplace_back(Z3ContextPool::variable(ctx, "x^", k, width));
     stats.nrOfSatVars++;
   }
 
-  for (std::size_t i = 0U; i < depthOne; i++) {
-    const auto layer = circOneRep.generatorMappings.at(
-        i); // generator<>generator map for level i
-    for (const auto& [from, to] : layer) {
-      const auto g1 = generators.at(circOneRep.idGeneratorMap.at(from));
-      const auto g2 = generators.at(circOneRep.idGeneratorMap.at(to));
-
-      // create [x^l]_2 = i <=> [x^l']_2 = k for each generator mapping
-      const auto left =
-          varsOne[i] == ctx.bv_val(static_cast<std::uint64_t>(g1), bitwidth);
-      const auto right = varsOne[i + 1U] ==
-                         ctx.bv_val(static_cast<std::uint64_t>(g2), bitwidth);
-      const auto cons = (left == right);
-      solver.add(cons);
-      stats.nrOfFunctionalConstr++;
-    }
-  }
-
   if (blockingConstraintsNeeded) {
     for (const auto& var : varsOne) {
-      const auto cons = ult(
-          var, ctx.bv_val(static_cast<std::uint64_t>(generatorCnt), bitwidth));
+      const auto cons = ult(var, z3.value(generatorCnt, width));
       solver.add(cons); // [x^l]_2 < m
     }
   }
   /// encode second circuit
   auto                  depthTwo = circTwoRep.generatorMappings.size();
   std::vector<z3::expr> varsTwo{};
-  varsOne.reserve(depthTwo + 1U);
-  bvName = "x'^";
+  varsTwo.reserve(depthTwo + 1U);
 
   for (std::size_t k = 0U; k <= depthTwo; k++) {
     // create bitvector [x^k]_2 with respective bitwidth for each level k of ckt
-    std::stringstream ss{};
-    ss << bvName << k; //
-    const auto tmp = ctx.bv_const(ss.str().c_str(), bitwidth);
-    varsTwo.emplace_back(tmp);
+    varsTwo.emplace_back(Z3ContextPool::variable(ctx, "x'^", k, width));
     stats.nrOfSatVars++;
   }
 
-  for (std::size_t i = 0U; i < depthTwo; i++) {
-    const auto layer = circTwoRep.generatorMappings.at(
-        i); // generator<>generator map for level i
-    for (const auto& [from, to] : layer) {
-      const auto g1 = generators.at(circTwoRep.idGeneratorMap.at(from));
-      const auto g2 = generators.at(circTwoRep.idGeneratorMap.at(to));
-
-      // create [x^l]_2 = i <=> [x^l']_2 = k for each generator mapping
-      const auto left =
-          varsTwo[i] == ctx.bv_val(static_cast<std::uint64_t>(g1), bitwidth);
-      const auto right = varsTwo[i + 1U] ==
-                         ctx.bv_val(static_cast<std::uint64_t>(g2), bitwidth);
-      const auto cons = (left == right);
-      solver.add(cons);
-      stats.nrOfFunctionalConstr++;
-    }
-  }
+  // create [x^l]_2 = i <=> [x^l']_2 = k for each generator mapping of both
+  // circuits
+  addMappingConstraints({&circOneRep, &circTwoRep}, {"x^", "x'^"}, true, width,
+                        z3, solver);
 
   if (blockingConstraintsNeeded) {
     for (const auto& var : varsTwo) {
-      const auto cons = ult(
-          var, ctx.bv_val(static_cast<std::uint64_t>(generatorCnt), bitwidth));
+      const auto cons = ult(var, z3.value(generatorCnt, width));
       solver.add(cons); // [x^l]_2 < m
     }
   }
@@ -391,8 +1569,7 @@ void SatEncoder::constructMiterInstance(
   // well
   const auto equalInputs    = varsOne.front() == varsTwo.front();
   const auto unequalOutputs = varsOne.back() != varsTwo.back();
-  const auto nrOfInputs =
-      ctx.bv_val(static_cast<std::uint64_t>(nrOfInputGenerators), bitwidth);
+  const auto nrOfInputs = z3.value(nrOfInputGenerators, width);
   const auto input1 = ult(varsOne.front(), nrOfInputs);
   const auto input2 = ult(varsTwo.front(), nrOfInputs);
 
@@ -406,25 +1583,416 @@ void SatEncoder::constructMiterInstance(
           .count();
 }
 
-bool SatEncoder::isClifford(const qc::QuantumComputation& qc) {
+void SatEncoder::addMappingConstraints(
+    const std::vector<const SatEncoder::CircuitRepresentation*>&
+                                         representations,
+    const std::vector<std::string_view>& prefixes, bool equivalence,
+    unsigned bitwidth, Z3ContextPool::Lease& z3, z3::solver& solver,
+    std::size_t firstLevel, std::size_t endLevel) {
+  // generator<>generator map of each level in the order of emission
+  struct Level {
+    std::string_view                         prefix;
+    std::size_t                              level;
+    const std::map<std::size_t, std::size_t>* mappings;
+  };
+  std::vector<Level> levels{};
+  std::size_t        nrOfMappings = 0U;
+  for (std::size_t i = 0U; i < representations.size(); i++) {
+    const auto& generatorMappings = representations[i]->generatorMappings;
+    const auto end = std::min(endLevel, generatorMappings.size());
+    for (std::size_t level = firstLevel; level < end; level++) {
+      levels.push_back({prefixes.at(i), level, &generatorMappings[level]});
+      nrOfMappings += generatorMappings[level].size();
+    }
+  }
+  stats.nrOfFunctionalConstr += nrOfMappings;
+  const auto constraintOf = [equivalence](const z3::expr& left,
+                                          const z3::expr& right) {
+    return equivalence ? left == right : z3::implies(left, right);
+  };
+
+  auto nrOfThreads = constructionThreads;
+  if (nrOfThreads == 0U) {
+    nrOfThreads =
+        std::max<std::size_t>(std::thread::hardware_concurrency(), 1U);
+  }
+  nrOfThreads = std::min(nrOfThreads, nrOfMappings);
+  if (nrOfThreads <= 1U || nrOfMappings < minParallelMappings) {
+    auto& ctx = z3.ctx();
+    for (const auto& [prefix, level, mappings] : levels) {
+      const auto left  = Z3ContextPool::variable(ctx, prefix, level, bitwidth);
+      const auto right =
+          Z3ContextPool::variable(ctx, prefix, level + 1U, bitwidth);
+      for (const auto& [from, to] : *mappings) {
+        solver.add(constraintOf(left == z3.value(from, bitwidth),
+                                right == z3.value(to, bitwidth)));
+      }
+    }
+    return;
+  }
+
+  // every thread builds a contiguous range of the constraints in its own
+  // context. The buffers are destroyed before their contexts.
+  const auto chunkSize = (nrOfMappings + nrOfThreads - 1U) / nrOfThreads;
+  std::vector<std::unique_ptr<z3::context>> contexts{};
+  std::vector<z3::expr_vector>              buffers{};
+  std::vector<std::exception_ptr>           errors(nrOfThreads);
+  contexts.reserve(nrOfThreads);
+  buffers.reserve(nrOfThreads);
+  for (std::size_t t = 0U; t < nrOfThreads; t++) {
+    buffers.emplace_back(
+        *contexts.emplace_back(std::make_unique<z3::context>()));
+  }
+  std::vector<std::thread> workers{};
+  workers.reserve(nrOfThreads);
+  for (std::size_t t = 0U; t < nrOfThreads; t++) {
+    workers.emplace_back([&, t]() {
+      try {
+        auto&       ctx   = *contexts[t];
+        const auto  begin = t * chunkSize;
+        const auto  end   = std::min(begin + chunkSize, nrOfMappings);
+        std::size_t index = 0U;
+        for (const auto& [prefix, level, mappings] : levels) {
+          if (index >= end) {
+            break;
+          }
+          if (index + mappings->size() <= begin) {
+            index += mappings->size();
+            continue;
+          }
+          auto it = mappings->begin();
+          if (index < begin) {
+            std::advance(it, begin - index);
+            index = begin;
+          }
+          const auto left =
+              Z3ContextPool::variable(ctx, prefix, level, bitwidth);
+          const auto right =
+              Z3ContextPool::variable(ctx, prefix, level + 1U, bitwidth);
+          for (; it != mappings->end() && index < end; ++it, ++index) {
+            const auto from = static_cast<std::uint64_t>(it->first);
+            const auto to   = static_cast<std::uint64_t>(it->second);
+            buffers[t].push_back(
+                constraintOf(left == ctx.bv_val(from, bitwidth),
+                             right == ctx.bv_val(to, bitwidth)));
+          }
+        }
+      } catch (...) {
+        errors[t] = std::current_exception();
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  for (const auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+  // bulk translation of each buffer into the context of the solver
+  for (const auto& buffer : buffers) {
+    const z3::expr_vector constraints(z3.ctx(), buffer);
+    for (unsigned i = 0U; i < constraints.size(); i++) {
+      solver.add(constraints[i]);
+    }
+  }
+}
+
+bool SatEncoder::isSupported(const qc::QuantumComputation& qc) {
   qc::OpType opType;
   for (const auto& op : qc) {
     opType = op->getType();
     if (opType != qc::OpType::H && opType != qc::OpType::S &&
         opType != qc::OpType::Sdg && opType != qc::OpType::X &&
         opType != qc::OpType::Z && opType != qc::OpType::Y &&
-        opType != qc::OpType::I) {
+        opType != qc::OpType::I && opType != qc::OpType::T &&
+        opType != qc::OpType::Tdg) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SatEncoder::exceedsMaxTCount(const CliffordCircuit& circuit) const {
+  const auto tCount = std::count_if(
+      circuit.begin(), circuit.end(), [](const CliffordGate& gate) {
+        return gate.type == static_cast<std::uint8_t>(GateType::T) ||
+               gate.type == static_cast<std::uint8_t>(GateType::Tdg);
+      });
+  return static_cast<std::size_t>(tCount) > maxTCount;
+}
+
+bool SatEncoder::isValid(const CliffordCircuit& circuit) {
+  for (const auto& gate : circuit) {
+    if (gate.type > static_cast<std::uint8_t>(GateType::Tdg) ||
+        gate.target < 0 ||
+        static_cast<std::size_t>(gate.target) >= circuit.nrOfQubits) {
+      return false;
+    }
+    if (gate.control >= 0 &&
+        (gate.type != static_cast<std::uint8_t>(GateType::X) ||
+         gate.control == gate.target ||
+         static_cast<std::size_t>(gate.control) >= circuit.nrOfQubits)) {
+      return false;
+    }
+    if (gate.control < -1) {
       return false;
     }
   }
+  if (circuit.outputPermutation != nullptr) {
+    std::vector<bool> used(circuit.nrOfQubits);
+    for (std::size_t i = 0U; i < circuit.nrOfQubits; i++) {
+      const auto qubit = circuit.outputPermutation[i];
+      if (qubit >= circuit.nrOfQubits || used[qubit]) {
+        return false;
+      }
+      used[qubit] = true;
+    }
+  }
   return true;
 }
 
+std::optional<std::vector<CliffordGate>>
+SatEncoder::toGates(const qc::QuantumComputation& circuit) {
+  if (!isSupported(circuit)) {
+    return std::nullopt;
+  }
+  std::vector<CliffordGate> gates{};
+  gates.reserve(circuit.size());
+  for (const auto& op : circuit) {
+    CliffordGate gate{};
+    switch (op->getType()) {
+    case qc::OpType::I:
+      gate.type = static_cast<std::uint8_t>(GateType::I);
+      break;
+    case qc::OpType::H:
+      gate.type = static_cast<std::uint8_t>(GateType::H);
+      break;
+    case qc::OpType::S:
+      gate.type = static_cast<std::uint8_t>(GateType::S);
+      break;
+    case qc::OpType::Sdg:
+      gate.type = static_cast<std::uint8_t>(GateType::Sdg);
+      break;
+    case qc::OpType::X:
+      gate.type = static_cast<std::uint8_t>(GateType::X);
+      break;
+    case qc::OpType::Y:
+      gate.type = static_cast<std::uint8_t>(GateType::Y);
+      break;
+    case qc::OpType::T:
+      gate.type = static_cast<std::uint8_t>(GateType::T);
+      break;
+    case qc::OpType::Tdg:
+      gate.type = static_cast<std::uint8_t>(GateType::Tdg);
+      break;
+    default: // Z, see isSupported
+      gate.type = static_cast<std::uint8_t>(GateType::Z);
+      break;
+    }
+    // only single-qubit gates and CNOTs with a positive control are supported
+    if (op->getTargets().size() != 1U || op->getControls().size() > 1U) {
+      return std::nullopt;
+    }
+    gate.target = static_cast<std::int32_t>(op->getTargets().front());
+    if (op->isControlled()) {
+      const auto& control = *op->getControls().begin();
+      if (op->getType() != qc::OpType::X ||
+          control.type != qc::Control::Type::Pos) {
+        return std::nullopt;
+      }
+      gate.control = static_cast<std::int32_t>(control.qubit);
+    }
+    gates.emplace_back(gate);
+  }
+  return gates;
+}
+
+std::optional<SatEncoder::ConvertedCircuit>
+SatEncoder::convert(const qc::QuantumComputation& circuit) {
+  auto gates = toGates(circuit);
+  if (!gates) {
+    return std::nullopt;
+  }
+  const auto nrOfQubits = circuit.getNqubits();
+  const auto initial    = completePermutation(circuit.initialLayout, nrOfQubits);
+  const auto output     =
+      completePermutation(circuit.outputPermutation, nrOfQubits);
+  const auto logicalOf = [&initial](std::int32_t qubit) {
+    // qubits out of range are rejected by isValid
+    const auto physical = static_cast<std::size_t>(qubit);
+    if (physical >= initial.size()) {
+      return qubit;
+    }
+    return static_cast<std::int32_t>(initial[physical]);
+  };
+  for (auto& gate : *gates) {
+    gate.target = logicalOf(gate.target);
+    if (gate.control >= 0) {
+      gate.control = logicalOf(gate.control);
+    }
+  }
+
+  ConvertedCircuit result{nrOfQubits, std::move(*gates), {}};
+  // physical qubit p holds logical qubit initial[p] at the beginning and
+  // output[p] at the end
+  std::vector<std::uint32_t> permutation(nrOfQubits);
+  bool                       identity = true;
+  for (std::size_t p = 0U; p < nrOfQubits; p++) {
+    permutation[initial[p]] = output[p];
+    identity                = identity && initial[p] == output[p];
+  }
+  if (!identity) {
+    result.layout.outputPermutation = std::move(permutation);
+  }
+  if (circuit.getNancillae() > 0U) {
+    result.layout.ancillary.resize(nrOfQubits);
+    for (std::size_t q = 0U; q < nrOfQubits; q++) {
+      result.layout.ancillary[q] =
+          circuit.logicalQubitIsAncillary(static_cast<qc::Qubit>(q)) ? 1U : 0U;
+    }
+  }
+  return result;
+}
+
+CliffordCircuit SatEncoder::ConvertedCircuit::view() const {
+  CliffordCircuit result{nrOfQubits, gates.data(), gates.size()};
+  if (!layout.outputPermutation.empty()) {
+    result.outputPermutation = layout.outputPermutation.data();
+  }
+  if (!layout.ancillary.empty()) {
+    result.ancillary = layout.ancillary.data();
+  }
+  return result;
+}
+
+void SatEncoder::FingerprintBuilder::mix(std::uint64_t value) {
+  // two independent multiply-rotate lanes (see MurmurHash3)
+  low ^= value * 0x87C37B91114253D5ULL;
+  low = ((low << 31U) | (low >> 33U)) * 0x4CF5AD432745937FULL;
+  high ^= value * 0x4CF5AD432745937FULL;
+  high = ((high << 33U) | (high >> 31U)) * 0x87C37B91114253D5ULL;
+  high += low;
+
+  // polynomial in the 32-bit halves of all values
+  constexpr std::uint64_t base = 0x1F3D5B79A2C4E6ULL;
+  for (const auto half : {value & 0xFFFFFFFFU, value >> 32U}) {
+    check = (mulMod61(check, base) + half + 1U) % MERSENNE_61;
+  }
+}
+
+void SatEncoder::FingerprintBuilder::addRow(std::size_t size) {
+  if (nrOfBits > 0U) {
+    mix(word);
+  }
+  word     = 0U;
+  nrOfBits = 0U;
+  mix(size);
+}
+
+void SatEncoder::FingerprintBuilder::addBit(bool bit) {
+  word |= static_cast<std::uint64_t>(bit) << nrOfBits;
+  if (++nrOfBits == 64U) {
+    mix(word);
+    word     = 0U;
+    nrOfBits = 0U;
+  }
+}
+
+SatEncoder::Fingerprint SatEncoder::FingerprintBuilder::finish() {
+  if (nrOfBits > 0U) {
+    mix(word);
+  }
+  const auto fmix = [](std::uint64_t k) {
+    k ^= k >> 33U;
+    k *= 0xFF51AFD7ED558CCDULL;
+    k ^= k >> 33U;
+    k *= 0xC4CEB9FE1A85EC53ULL;
+    k ^= k >> 33U;
+    return k;
+  };
+  low += high;
+  high += low;
+  return {fmix(low), fmix(high), check};
+}
+
+SatEncoder::Fingerprint
+SatEncoder::fingerprintOf(const std::vector<std::vector<bool>>& generator) {
+  FingerprintBuilder builder;
+  for (const auto& row : generator) {
+    builder.addRow(row.size());
+    for (const auto bit : row) {
+      builder.addBit(bit);
+    }
+  }
+  return builder.finish();
+}
+
+SatEncoder::Fingerprint SatEncoder::QState::fingerprint() const {
+  if (!rowOf.empty()) {
+    return fingerprintOf(getLevelGenerator());
+  }
+  // hashes the rows in the layout of getLevelGenerator without copying them
+  FingerprintBuilder builder;
+  for (std::size_t i = 0U; i < r.size(); i++) {
+    builder.addRow(2U * n + 1U);
+    for (std::size_t j = 0U; j < n; j++) {
+      builder.addBit(x[i][j]);
+    }
+    for (std::size_t j = 0U; j < n; j++) {
+      builder.addBit(z[i][j]);
+    }
+    builder.addBit(r[i] == 1);
+  }
+  return builder.finish();
+}
+
 std::vector<std::vector<bool>> SatEncoder::QState::getLevelGenerator() const {
   std::size_t                    size = (2U * n) + 1U;
   std::vector<std::vector<bool>> result{};
 
-  for (std::size_t i = 0U; i < n; i++) {
+  if (!rowOf.empty()) {
+    // Pauli sums. Terms are sorted, such that equal sums yield equal rows,
+    // and each term is encoded as x, z, and its coefficient (a, b, k). Rows
+    // that are a single Pauli operator keep the encoding below
+    const auto appendBits = [](std::vector<bool>& gen, std::uint64_t value,
+                               std::size_t nrOfBits) {
+      for (std::size_t bit = 0U; bit < nrOfBits; bit++) {
+        gen.emplace_back(((value >> bit) & 1U) != 0U);
+      }
+    };
+    std::vector<std::vector<std::size_t>> terms(rowOf.back() + 1U);
+    for (std::size_t i = 0U; i < rowOf.size(); i++) {
+      terms[rowOf[i]].emplace_back(i);
+    }
+    for (auto& rowTerms : terms) {
+      std::sort(rowTerms.begin(), rowTerms.end(),
+                [this](std::size_t lhs, std::size_t rhs) {
+                  return std::tie(x[lhs], z[lhs]) < std::tie(x[rhs], z[rhs]);
+                });
+      std::vector<bool> gen{};
+      for (const auto i : rowTerms) {
+        const auto coefficient =
+            r[i] == 1 ? -coefficients[i] : coefficients[i];
+        if (rowTerms.size() == 1U && coefficient.isUnit()) {
+          gen.insert(gen.end(), x[i].begin(), x[i].end());
+          gen.insert(gen.end(), z[i].begin(), z[i].end());
+          gen.emplace_back(coefficient.a < 0);
+          break;
+        }
+        gen.insert(gen.end(), x[i].begin(), x[i].end());
+        gen.insert(gen.end(), z[i].begin(), z[i].end());
+        appendBits(gen, static_cast<std::uint64_t>(coefficient.a), 64U);
+        appendBits(gen, static_cast<std::uint64_t>(coefficient.b), 64U);
+        appendBits(gen, coefficient.k, 8U);
+      }
+      result.emplace_back(gen);
+    }
+    return result;
+  }
+
+  for (std::size_t i = 0U; i < r.size(); i++) {
     std::vector<bool> gen(size);
     for (std::size_t j = 0U; j < n; j++) {
       gen[j] = x.at(i).at(j);
@@ -449,6 +2017,18 @@ SatEncoder::QState SatEncoder::initializeState(unsigned long      nrOfQubits,
       std::vector<std::vector<bool>>(nrOfQubits, std::vector<bool>(nrOfQubits));
   result.r = std::vector<int>(nrOfQubits, 0);
 
+  if (!input.empty() && (input.front() == '+' || input.front() == '-')) {
+    // single Pauli operator, e.g. +XZ, that is propagated on its own
+    result.x = std::vector<std::vector<bool>>(1U, std::vector<bool>(nrOfQubits));
+    result.z = std::vector<std::vector<bool>>(1U, std::vector<bool>(nrOfQubits));
+    result.r = std::vector<int>(1U, input.front() == '-' ? 1 : 0);
+    for (std::size_t i = 1U; i < input.length() && i <= nrOfQubits; i++) {
+      result.x[0][i - 1U] = input[i] == 'X' || input[i] == 'Y';
+      result.z[0][i - 1U] = input[i] == 'Z' || input[i] == 'Y';
+    }
+    return result;
+  }
+
   for (std::size_t i = 0U; i < nrOfQubits; i++) {
     result.z[i][i] = true; // initial 0..0 state corresponds to x matrix all
                            // zero and z matrix = Id_n
@@ -486,14 +2066,41 @@ SatEncoder::QState SatEncoder::initializeState(unsigned long      nrOfQubits,
   }
   return result;
 }
+std::vector<std::string>
+SatEncoder::allComputationalBasisInputs(std::size_t nrOfQubits) {
+  return allStabilizerInputs(nrOfQubits, 0U);
+}
+
+std::vector<std::string>
+SatEncoder::allStabilizerInputs(std::size_t nrOfQubits,
+                                std::size_t nrOfStabilizerQubits) {
+  std::vector<std::string> result{};
+  for (std::size_t i = 0U; i < nrOfQubits; i++) {
+    std::string pauli(nrOfQubits + 1U, 'I');
+    pauli[0]      = '+';
+    pauli[i + 1U] = 'Z';
+    result.emplace_back(pauli);
+    if (i < nrOfStabilizerQubits) {
+      pauli[i + 1U] = 'X';
+      result.emplace_back(pauli);
+    }
+  }
+  return result;
+}
+
 const Statistics& SatEncoder::getStats() const { return stats; }
 
+const std::optional<SatEncoder::Counterexample>&
+SatEncoder::getCounterexample() const {
+  return counterexample;
+}
+
 void SatEncoder::QState::applyCNOT(unsigned long control,
                                    unsigned long target) {
   if (target >= n || control >= n) {
     return;
   }
-  for (std::size_t i = 0U; i < n; ++i) {
+  for (std::size_t i = 0U; i < r.size(); ++i) {
     r[i] ^= (x[i][control] * z[i][target]) * (x[i][target] ^ z[i][control] ^ 1);
     x[i][target]  = x[i][target] ^ x[i][control];
     z[i][control] = z[i][control] ^ z[i][target];
@@ -504,7 +2111,7 @@ void SatEncoder::QState::applyH(unsigned long target) {
   if (target >= n) {
     return;
   }
-  for (std::size_t i = 0U; i < n; i++) {
+  for (std::size_t i = 0U; i < r.size(); i++) {
     r[i] ^= x[i][target] * z[i][target];
     x[i][target] = x[i][target] ^ z[i][target];
     z[i][target] = x[i][target] ^ z[i][target];
@@ -516,8 +2123,279 @@ void SatEncoder::QState::applyS(unsigned long target) {
   if (target >= n) {
     return;
   }
-  for (std::size_t i = 0U; i < n; ++i) {
+  for (std::size_t i = 0U; i < r.size(); ++i) {
     r[i] ^= x[i][target] * z[i][target];
     z[i][target] = z[i][target] ^ x[i][target];
   }
 }
+
+void SatEncoder::QState::applyT(unsigned long target, bool inverse) {
+  if (target >= n) {
+    return;
+  }
+  if (rowOf.empty()) {
+    rowOf.resize(r.size());
+    std::iota(rowOf.begin(), rowOf.end(), 0U);
+    coefficients.assign(r.size(), Coefficient{});
+  }
+  // T X Tdg = (X + Y) / sqrt2 and T Y Tdg = (Y - X) / sqrt2, the signs of the
+  // second terms are flipped for Tdg. Terms are merged per generator row
+  using Term = std::tuple<std::size_t, std::vector<bool>, std::vector<bool>>;
+  std::map<Term, Coefficient> terms{};
+  const auto                  addTerm = [&terms](Term term,
+                                  const Coefficient& coefficient) {
+    const auto [it, inserted] = terms.emplace(std::move(term), coefficient);
+    if (!inserted) {
+      it->second = it->second + coefficient;
+    }
+  };
+  for (std::size_t i = 0U; i < r.size(); i++) {
+    const auto coefficient = r[i] == 1 ? -coefficients[i] : coefficients[i];
+    if (!x[i][target]) {
+      addTerm({rowOf[i], x[i], z[i]}, coefficient);
+      continue;
+    }
+    const auto half    = coefficient.divideBySqrt2();
+    auto       flipped = z[i];
+    flipped[target]    = !flipped[target];
+    addTerm({rowOf[i], x[i], z[i]}, half);
+    addTerm({rowOf[i], x[i], flipped}, z[i][target] != inverse ? -half : half);
+  }
+
+  x.clear();
+  z.clear();
+  r.clear();
+  rowOf.clear();
+  coefficients.clear();
+  for (auto& [term, coefficient] : terms) {
+    if (coefficient.isZero()) {
+      continue;
+    }
+    rowOf.emplace_back(std::get<0>(term));
+    x.emplace_back(std::get<1>(term));
+    z.emplace_back(std::get<2>(term));
+    r.emplace_back(0);
+    coefficients.emplace_back(coefficient);
+  }
+}
+
+void SatEncoder::QState::permuteColumns(const std::uint32_t* permutation) {
+  for (std::size_t i = 0U; i < x.size(); i++) {
+    std::vector<bool> permutedX(n);
+    std::vector<bool> permutedZ(n);
+    for (std::size_t j = 0U; j < n; j++) {
+      permutedX[permutation[j]] = x[i][j];
+      permutedZ[permutation[j]] = z[i][j];
+    }
+    x[i] = std::move(permutedX);
+    z[i] = std::move(permutedZ);
+  }
+}
+
+SatEncoder::PackedQState::PackedQState(const QState& state)
+    : n(state.n), nrOfRows(state.r.size()), prevGenId(state.prevGenId),
+      rowOf(state.rowOf), coefficients(state.coefficients) {
+  const auto wordsPerRow = (n + 63U) / 64U;
+  words.resize(nrOfRows * 2U * wordsPerRow + (nrOfRows + 63U) / 64U);
+  const auto setBit = [this](std::size_t index) {
+    words[index / 64U] |= std::uint64_t{1} << (index % 64U);
+  };
+  for (std::size_t i = 0U; i < nrOfRows; i++) {
+    const auto offset = i * 2U * wordsPerRow * 64U;
+    for (std::size_t j = 0U; j < n; j++) {
+      if (state.x[i][j]) {
+        setBit(offset + j);
+      }
+      if (state.z[i][j]) {
+        setBit(offset + wordsPerRow * 64U + j);
+      }
+    }
+    if (state.r[i] == 1) {
+      setBit(nrOfRows * 2U * wordsPerRow * 64U + i);
+    }
+  }
+}
+
+SatEncoder::QState SatEncoder::PackedQState::unpack() const {
+  const auto wordsPerRow = (n + 63U) / 64U;
+  const auto bit         = [this](std::size_t index) {
+    return ((words[index / 64U] >> (index % 64U)) & 1U) != 0U;
+  };
+  QState state{};
+  state.n = n;
+  state.x = std::vector<std::vector<bool>>(nrOfRows, std::vector<bool>(n));
+  state.z = std::vector<std::vector<bool>>(nrOfRows, std::vector<bool>(n));
+  state.r = std::vector<int>(nrOfRows);
+  for (std::size_t i = 0U; i < nrOfRows; i++) {
+    const auto offset = i * 2U * wordsPerRow * 64U;
+    for (std::size_t j = 0U; j < n; j++) {
+      state.x[i][j] = bit(offset + j);
+      state.z[i][j] = bit(offset + wordsPerRow * 64U + j);
+    }
+    state.r[i] = bit(nrOfRows * 2U * wordsPerRow * 64U + i) ? 1 : 0;
+  }
+  state.prevGenId    = prevGenId;
+  state.rowOf        = rowOf;
+  state.coefficients = coefficients;
+  return state;
+}
+
+std::size_t SatEncoder::PackedQState::bytes() const {
+  return sizeof(PackedQState) + words.size() * sizeof(std::uint64_t) +
+         rowOf.size() * sizeof(std::size_t) +
+         coefficients.size() * sizeof(Coefficient);
+}
+
+template <std::size_t Words>
+SatEncoder::FixedQState<Words>::FixedQState(const QState& state)
+    : n(state.n), nrOfRows(state.r.size()), prevGenId(state.prevGenId) {
+  for (std::size_t i = 0U; i < nrOfRows; i++) {
+    const auto word = i / 64U;
+    const auto mask = std::uint64_t{1} << (i % 64U);
+    for (std::size_t j = 0U; j < n; j++) {
+      if (state.x[i][j]) {
+        x[j][word] |= mask;
+      }
+      if (state.z[i][j]) {
+        z[j][word] |= mask;
+      }
+    }
+    if (state.r[i] == 1) {
+      r[word] |= mask;
+    }
+  }
+}
+
+template <std::size_t Words>
+SatEncoder::QState SatEncoder::FixedQState<Words>::toQState() const {
+  QState state{};
+  state.n = n;
+  state.x = std::vector<std::vector<bool>>(nrOfRows, std::vector<bool>(n));
+  state.z = std::vector<std::vector<bool>>(nrOfRows, std::vector<bool>(n));
+  state.r = std::vector<int>(nrOfRows);
+  for (std::size_t i = 0U; i < nrOfRows; i++) {
+    for (std::size_t j = 0U; j < n; j++) {
+      state.x[i][j] = bit(x[j], i);
+      state.z[i][j] = bit(z[j], i);
+    }
+    state.r[i] = bit(r, i) ? 1 : 0;
+  }
+  state.prevGenId = prevGenId;
+  return state;
+}
+
+template <std::size_t Words>
+std::vector<std::vector<bool>>
+SatEncoder::FixedQState<Words>::getLevelGenerator() const {
+  std::vector<std::vector<bool>> result(nrOfRows,
+                                        std::vector<bool>((2U * n) + 1U));
+  for (std::size_t i = 0U; i < nrOfRows; i++) {
+    for (std::size_t j = 0U; j < n; j++) {
+      result[i][j]     = bit(x[j], i);
+      result[i][n + j] = bit(z[j], i);
+    }
+    result[i][n + n] = bit(r, i);
+  }
+  return result;
+}
+
+template <std::size_t Words>
+SatEncoder::Fingerprint SatEncoder::FixedQState<Words>::fingerprint() const {
+  FingerprintBuilder builder;
+  for (std::size_t i = 0U; i < nrOfRows; i++) {
+    builder.addRow(2U * n + 1U);
+    for (std::size_t j = 0U; j < n; j++) {
+      builder.addBit(bit(x[j], i));
+    }
+    for (std::size_t j = 0U; j < n; j++) {
+      builder.addBit(bit(z[j], i));
+    }
+    builder.addBit(bit(r, i));
+  }
+  return builder.finish();
+}
+
+template <std::size_t Words>
+void SatEncoder::FixedQState<Words>::applyCNOT(unsigned long control,
+                                               unsigned long target) {
+  if (target >= n || control >= n) {
+    return;
+  }
+  for (std::size_t w = 0U; w < Words; w++) {
+    r[w] ^= x[control][w] & z[target][w] & ~(x[target][w] ^ z[control][w]);
+    x[target][w] ^= x[control][w];
+    z[control][w] ^= z[target][w];
+  }
+}
+
+template <std::size_t Words>
+void SatEncoder::FixedQState<Words>::applyH(unsigned long target) {
+  if (target >= n) {
+    return;
+  }
+  for (std::size_t w = 0U; w < Words; w++) {
+    r[w] ^= x[target][w] & z[target][w];
+  }
+  std::swap(x[target], z[target]);
+}
+
+template <std::size_t Words>
+void SatEncoder::FixedQState<Words>::applyS(unsigned long target) {
+  if (target >= n) {
+    return;
+  }
+  for (std::size_t w = 0U; w < Words; w++) {
+    r[w] ^= x[target][w] & z[target][w];
+    z[target][w] ^= x[target][w];
+  }
+}
+
+template <std::size_t Words>
+void SatEncoder::FixedQState<Words>::permuteColumns(
+    const std::uint32_t* permutation) {
+  const auto previousX = x;
+  const auto previousZ = z;
+  for (std::size_t j = 0U; j < n; j++) {
+    x[permutation[j]] = previousX[j];
+    z[permutation[j]] = previousZ[j];
+  }
+}
+
+SatEncoder::Coefficient SatEncoder::Coefficient::operator-() const {
+  return {-a, -b, k};
+}
+
+SatEncoder::Coefficient
+SatEncoder::Coefficient::operator+(const Coefficient& other) const {
+  const auto  maxK   = std::max(k, other.k);
+  const auto  scale  = std::int64_t{1} << (maxK - k);
+  const auto  scaleO = std::int64_t{1} << (maxK - other.k);
+  Coefficient result{a * scale + other.a * scaleO,
+                     b * scale + other.b * scaleO, maxK};
+  result.normalize();
+  return result;
+}
+
+SatEncoder::Coefficient SatEncoder::Coefficient::divideBySqrt2() const {
+  // (a + b sqrt2) / (sqrt2 2^k) = (2b + a sqrt2) / 2^(k+1)
+  Coefficient result{2 * b, a, static_cast<std::uint8_t>(k + 1U)};
+  result.normalize();
+  return result;
+}
+
+double SatEncoder::Coefficient::toDouble() const {
+  return (static_cast<double>(a) + static_cast<double>(b) * std::sqrt(2.0)) /
+         std::ldexp(1.0, k);
+}
+
+void SatEncoder::Coefficient::normalize() {
+  if (isZero()) {
+    k = 0U;
+    return;
+  }
+  while (k > 0U && a % 2 == 0 && b % 2 == 0) {
+    a /= 2;
+    b /= 2;
+    k--;
+  }
+}
@@ -0,0 +1,508 @@
+#include "ShardedChecker.hpp"
+
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <pthread.h>
+#endif
+
+extern char** environ; // NOLINT(readability-redundant-declaration)
+#endif
+
+namespace {
+constexpr std::uint64_t TASK_VERSION = 1U;
+
+std::filesystem::path taskFile(const std::string& directory,
+                               std::size_t        shard) {
+  return std::filesystem::path(directory) /
+         ("shard-" + std::to_string(shard) + ".task.json");
+}
+
+std::filesystem::path resultFile(const std::string& directory,
+                                 std::size_t        shard) {
+  return std::filesystem::path(directory) /
+         ("shard-" + std::to_string(shard) + ".result.json");
+}
+
+std::filesystem::path cancelFile(const std::string& directory) {
+  return std::filesystem::path(directory) / "cancel";
+}
+
+// writes to a temporary file first, such that readers never observe a
+// partially written file
+void writeJsonFile(const std::filesystem::path& file, const json& content) {
+  std::stringstream tmpName{};
+  tmpName << file.string() << "." << std::hex << std::random_device{}()
+          << ".tmp";
+  {
+    std::ofstream ofs(tmpName.str());
+    ofs << content.dump();
+    if (!ofs.good()) {
+      throw std::runtime_error("Could not write " + file.string());
+    }
+  }
+  std::filesystem::rename(tmpName.str(), file);
+}
+
+json readJsonFile(const std::filesystem::path& file) {
+  std::ifstream ifs(file);
+  if (!ifs.good()) {
+    throw std::runtime_error("Could not read " + file.string());
+  }
+  return json::parse(ifs);
+}
+
+json toJson(const CliffordCircuit& circuit) {
+  json gates = json::array();
+  for (const auto& gate : circuit) {
+    gates.push_back({gate.type, gate.control, gate.target});
+  }
+  json result{{"nrOfQubits", circuit.nrOfQubits}, {"gates", gates}};
+  if (circuit.outputPermutation != nullptr) {
+    result["outputPermutation"] = std::vector<std::uint32_t>(
+        circuit.outputPermutation,
+        circuit.outputPermutation + circuit.nrOfQubits);
+  }
+  if (circuit.ancillary != nullptr) {
+    result["ancillary"] = std::vector<std::uint8_t>(
+        circuit.ancillary, circuit.ancillary + circuit.nrOfQubits);
+  }
+  return result;
+}
+
+SatEncoder::ConvertedCircuit circuitFromJson(const json& j) {
+  SatEncoder::ConvertedCircuit circuit{};
+  circuit.nrOfQubits = j.at("nrOfQubits").get<std::size_t>();
+  for (const auto& gate : j.at("gates")) {
+    circuit.gates.push_back({gate.at(0).get<std::uint8_t>(),
+                             gate.at(1).get<std::int32_t>(),
+                             gate.at(2).get<std::int32_t>()});
+  }
+  if (j.contains("outputPermutation")) {
+    j.at("outputPermutation").get_to(circuit.layout.outputPermutation);
+  }
+  if (j.contains("ancillary")) {
+    j.at("ancillary").get_to(circuit.layout.ancillary);
+  }
+  if ((!circuit.layout.outputPermutation.empty() &&
+       circuit.layout.outputPermutation.size() != circuit.nrOfQubits) ||
+      (!circuit.layout.ancillary.empty() &&
+       circuit.layout.ancillary.size() != circuit.nrOfQubits)) {
+    throw std::runtime_error("Layout does not match the number of qubits");
+  }
+  return circuit;
+}
+
+json toJson(const SatEncoder::Limits& limits) {
+  return json{{"timeout", limits.timeout},
+              {"memory", limits.memory},
+              {"preprocTimeout", limits.preprocTimeout},
+              {"preprocMemory", limits.preprocMemory},
+              {"solvingTimeout", limits.solvingTimeout},
+              {"solvingMemory", limits.solvingMemory}};
+}
+
+SatEncoder::Limits limitsFromJson(const json& j) {
+  SatEncoder::Limits limits{};
+  j.at("timeout").get_to(limits.timeout);
+  j.at("memory").get_to(limits.memory);
+  j.at("preprocTimeout").get_to(limits.preprocTimeout);
+  j.at("preprocMemory").get_to(limits.preprocMemory);
+  j.at("solvingTimeout").get_to(limits.solvingTimeout);
+  j.at("solvingMemory").get_to(limits.solvingMemory);
+  return limits;
+}
+
+// result of a shard that could not be checked
+json failedResult(std::size_t shard, const std::string& reason) {
+  Statistics stats{};
+  stats.unknownReason = reason;
+  return json{{"shard", shard},
+              {"statistics", stats.to_json()},
+              {"counterexample", nullptr}};
+}
+
+bool isNotEquivalent(const json& result) {
+  return result.at("statistics").at("result").get<EquivalenceResult>() ==
+         EquivalenceResult::NotEquivalent;
+}
+
+#ifndef _WIN32
+// a forked child only contains the calling thread, locks held by any other
+// thread (e.g., of malloc or z3) would never be released in the child
+bool isSingleThreaded() {
+#if defined(__linux__)
+  std::error_code ec{};
+  std::size_t     nrOfThreads = 0U;
+  for (std::filesystem::directory_iterator it("/proc/self/task", ec), end;
+       !ec && it != end; it.increment(ec)) {
+    nrOfThreads++;
+  }
+  return !ec && nrOfThreads == 1U;
+#elif defined(__APPLE__)
+  return pthread_is_threaded_np() == 0;
+#else
+  return false;
+#endif
+}
+
+// starts the command with the task file as its last argument and its
+// standard output redirected to fd
+pid_t spawnWorker(const std::vector<std::string>& command,
+                  const std::string& taskFile, int fd) {
+  std::vector<std::string> args(command);
+  args.emplace_back(taskFile);
+  std::vector<char*> argv{};
+  for (auto& arg : args) {
+    argv.emplace_back(arg.data());
+  }
+  argv.emplace_back(nullptr);
+  posix_spawn_file_actions_t actions{};
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, fd, STDOUT_FILENO);
+  pid_t pid = -1;
+  if (::posix_spawnp(&pid, argv.front(), &actions, nullptr, argv.data(),
+                     environ) != 0) {
+    pid = -1;
+  }
+  posix_spawn_file_actions_destroy(&actions);
+  return pid;
+}
+#endif
+} // namespace
+
+ShardedChecker::ShardedChecker(std::size_t workers) : nrOfWorkers(workers) {
+  if (nrOfWorkers == 0U) {
+    nrOfWorkers =
+        std::max<std::size_t>(std::thread::hardware_concurrency(), 1U);
+  }
+}
+
+std::size_t ShardedChecker::effectiveNrOfShards() const {
+  return nrOfShards == 0U ? nrOfWorkers : nrOfShards;
+}
+
+std::vector<std::vector<std::string>>
+ShardedChecker::partition(const std::vector<std::string>& inputs,
+                          std::size_t                     nrOfShards) {
+  if (inputs.empty()) {
+    return {{}};
+  }
+  nrOfShards = std::clamp<std::size_t>(nrOfShards, 1U, inputs.size());
+  std::vector<std::vector<std::string>> shards(nrOfShards);
+  for (std::size_t i = 0U; i < nrOfShards; i++) {
+    const auto begin = i * inputs.size() / nrOfShards;
+    const auto end   = (i + 1U) * inputs.size() / nrOfShards;
+    shards[i].assign(inputs.begin() + static_cast<std::ptrdiff_t>(begin),
+                     inputs.begin() + static_cast<std::ptrdiff_t>(end));
+  }
+  return shards;
+}
+
+bool ShardedChecker::testEqual(qc::QuantumComputation&         circuitOne,
+                               qc::QuantumComputation&         circuitTwo,
+                               const std::vector<std::string>& inputs) {
+  const auto convertedOne = SatEncoder::convert(circuitOne);
+  const auto convertedTwo = SatEncoder::convert(circuitTwo);
+  if (!convertedOne || !convertedTwo) {
+    std::cerr << "Circuits are not Clifford circuits" << std::endl;
+    stats               = Statistics{};
+    stats.unknownReason = "circuits are not Clifford circuits";
+    counterexample.reset();
+    return false;
+  }
+  return testEqual(convertedOne->view(), convertedTwo->view(), inputs);
+}
+
+bool ShardedChecker::testEqual(const CliffordCircuit&          circuitOne,
+                               const CliffordCircuit&          circuitTwo,
+                               const std::vector<std::string>& inputs) {
+  const auto shards = partition(inputs, effectiveNrOfShards());
+  mergeResults(runWorkers(circuitOne, circuitTwo, shards));
+  return stats.equal;
+}
+
+json ShardedChecker::runShard(std::size_t                     shard,
+                              const CliffordCircuit&          circuitOne,
+                              const CliffordCircuit&          circuitTwo,
+                              const std::vector<std::string>& inputs,
+                              const SatEncoder::Limits&       limits) {
+  try {
+    SatEncoder encoder{};
+    encoder.setLimits(limits);
+    encoder.testEqual(circuitOne, circuitTwo, inputs);
+    json result{{"shard", shard},
+                {"statistics", encoder.to_json()},
+                {"counterexample", nullptr}};
+    if (const auto& counterexample = encoder.getCounterexample()) {
+      result["counterexample"] = counterexample->to_json();
+    }
+    return result;
+  } catch (const std::exception& e) {
+    return failedResult(shard, e.what());
+  }
+}
+
+#ifndef _WIN32
+std::vector<json> ShardedChecker::runWorkers(
+    const CliffordCircuit& circuitOne, const CliffordCircuit& circuitTwo,
+    const std::vector<std::vector<std::string>>& shards) const {
+  const bool spawn = !workerCommand.empty();
+  if (!spawn && !isSingleThreaded()) {
+    return runThreads(circuitOne, circuitTwo, shards);
+  }
+  std::string directory{};
+  if (spawn) {
+    directory = (std::filesystem::temp_directory_path() /
+                 ("qusat-shards-" + std::to_string(std::random_device{}())))
+                    .string();
+    writeTasks(directory, circuitOne, circuitTwo, shards);
+  }
+
+  struct Worker {
+    pid_t       pid;
+    int         fd; // read end of the pipe
+    std::size_t shard;
+    std::string output;
+  };
+  std::vector<json>   results{};
+  std::vector<Worker> running{};
+  std::size_t         next  = 0U;
+  bool                found = false; // counterexample
+
+  while ((!found && next < shards.size()) || !running.empty()) {
+    while (!found && next < shards.size() && running.size() < nrOfWorkers) {
+      const auto shard = next++;
+      int        fds[2];
+      if (::pipe(fds) != 0) {
+        results.emplace_back(failedResult(shard, "could not create pipe"));
+        continue;
+      }
+      // workers started concurrently must not inherit the pipe
+      ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+      ::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+      const pid_t pid =
+          spawn ? spawnWorker(workerCommand,
+                              taskFile(directory, shard).string(), fds[1])
+                : ::fork();
+      if (pid == 0) {
+        // forked worker process, only writes its result and exits immediately
+        ::close(fds[0]);
+        const auto  output = runShard(shard, circuitOne, circuitTwo,
+                                      shards[shard], limits)
+                                .dump();
+        std::size_t written = 0U;
+        while (written < output.size()) {
+          const auto n =
+              ::write(fds[1], output.data() + written, output.size() - written);
+          if (n < 0 && errno != EINTR) {
+            ::_exit(1);
+          }
+          written += n > 0 ? static_cast<std::size_t>(n) : 0U;
+        }
+        ::_exit(0);
+      }
+      ::close(fds[1]);
+      if (pid < 0) {
+        ::close(fds[0]);
+        results.emplace_back(failedResult(shard, "could not start worker"));
+        continue;
+      }
+      running.push_back({pid, fds[0], shard, {}});
+    }
+    if (running.empty()) {
+      break;
+    }
+
+    std::vector<pollfd> pollFds{};
+    for (const auto& worker : running) {
+      pollFds.push_back({worker.fd, POLLIN, 0});
+    }
+    if (::poll(pollFds.data(), pollFds.size(), -1) < 0 && errno != EINTR) {
+      throw std::runtime_error("Could not wait for workers");
+    }
+    for (std::size_t i = pollFds.size(); i-- > 0U;) {
+      if (pollFds[i].revents == 0) {
+        continue;
+      }
+      auto&      worker = running[i];
+      char       buffer[4096];
+      const auto n = ::read(worker.fd, buffer, sizeof(buffer));
+      if (n > 0) {
+        worker.output.append(buffer, static_cast<std::size_t>(n));
+        continue;
+      }
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      // end of output, spawned workers write their result file instead
+      ::close(worker.fd);
+      ::waitpid(worker.pid, nullptr, 0);
+      try {
+        results.emplace_back(
+            spawn ? readJsonFile(resultFile(directory, worker.shard))
+                  : json::parse(worker.output));
+      } catch (const std::exception&) {
+        results.emplace_back(failedResult(worker.shard, "worker failed"));
+      }
+      found = found || isNotEquivalent(results.back());
+      running.erase(running.begin() + static_cast<std::ptrdiff_t>(i));
+    }
+
+    if (found) {
+      // short-circuit, the circuits are not equivalent
+      for (const auto& worker : running) {
+        ::kill(worker.pid, SIGKILL);
+        ::close(worker.fd);
+        ::waitpid(worker.pid, nullptr, 0);
+      }
+      running.clear();
+    }
+  }
+  if (spawn) {
+    std::error_code ec{};
+    std::filesystem::remove_all(directory, ec);
+  }
+  return results;
+}
+#else
+std::vector<json> ShardedChecker::runWorkers(
+    const CliffordCircuit& circuitOne, const CliffordCircuit& circuitTwo,
+    const std::vector<std::vector<std::string>>& shards) const {
+  return runThreads(circuitOne, circuitTwo, shards);
+}
+#endif
+
+std::vector<json> ShardedChecker::runThreads(
+    const CliffordCircuit& circuitOne, const CliffordCircuit& circuitTwo,
+    const std::vector<std::vector<std::string>>& shards) const {
+  // shards that have not been started are skipped once a counterexample is
+  // found
+  std::vector<json> results{};
+  std::mutex        mutex;
+  bool              found = false;
+  {
+    ThreadPool pool(nrOfWorkers);
+    for (std::size_t shard = 0U; shard < shards.size(); shard++) {
+      pool.submit([&, shard]() {
+        {
+          const std::lock_guard lock(mutex);
+          if (found) {
+            return;
+          }
+        }
+        auto result =
+            runShard(shard, circuitOne, circuitTwo, shards[shard], limits);
+        const std::lock_guard lock(mutex);
+        found = found || isNotEquivalent(result);
+        results.emplace_back(std::move(result));
+      });
+    }
+  }
+  return results;
+}
+
+void ShardedChecker::mergeResults(std::vector<json> results) {
+  std::sort(results.begin(), results.end(),
+            [](const json& lhs, const json& rhs) {
+              return lhs.at("shard").get<std::size_t>() <
+                     rhs.at("shard").get<std::size_t>();
+            });
+  stats = Statistics{};
+  counterexample.reset();
+  for (const auto& result : results) {
+    Statistics shardStats{};
+    shardStats.from_json(result.at("statistics"));
+    stats.merge(shardStats);
+    if (!counterexample && !result.at("counterexample").is_null()) {
+      counterexample.emplace().from_json(result.at("counterexample"));
+    }
+  }
+}
+
+std::size_t
+ShardedChecker::writeShardTasks(const std::string&              directory,
+                                const CliffordCircuit&          circuitOne,
+                                const CliffordCircuit&          circuitTwo,
+                                const std::vector<std::string>& inputs) const {
+  const auto shards = partition(inputs, effectiveNrOfShards());
+  writeTasks(directory, circuitOne, circuitTwo, shards);
+  return shards.size();
+}
+
+void ShardedChecker::writeTasks(
+    const std::string& directory, const CliffordCircuit& circuitOne,
+    const CliffordCircuit&                       circuitTwo,
+    const std::vector<std::vector<std::string>>& shards) const {
+  std::filesystem::create_directories(directory);
+  std::filesystem::remove(cancelFile(directory));
+  for (std::size_t shard = 0U; shard < shards.size(); shard++) {
+    std::filesystem::remove(resultFile(directory, shard));
+    writeJsonFile(taskFile(directory, shard),
+                  json{{"version", TASK_VERSION},
+                       {"shard", shard},
+                       {"circuitOne", toJson(circuitOne)},
+                       {"circuitTwo", toJson(circuitTwo)},
+                       {"inputs", shards[shard]},
+                       {"limits", toJson(limits)}});
+  }
+}
+
+bool ShardedChecker::runShardTask(const std::string& taskFile) {
+  const auto directory =
+      std::filesystem::path(taskFile).parent_path().string();
+  if (std::filesystem::exists(cancelFile(directory))) {
+    return false;
+  }
+  const auto task = readJsonFile(taskFile);
+  if (task.at("version").get<std::uint64_t>() != TASK_VERSION) {
+    throw std::runtime_error("Unsupported shard task version in " + taskFile);
+  }
+  const auto shard    = task.at("shard").get<std::size_t>();
+  const auto circuitOne = circuitFromJson(task.at("circuitOne"));
+  const auto circuitTwo = circuitFromJson(task.at("circuitTwo"));
+  const auto result     = runShard(
+      shard, circuitOne.view(), circuitTwo.view(),
+      task.at("inputs").get<std::vector<std::string>>(),
+      limitsFromJson(task.at("limits")));
+  writeJsonFile(resultFile(directory, shard), result);
+  return true;
+}
+
+bool ShardedChecker::collectShardResults(const std::string& directory,
+                                         std::size_t        nrOfTasks) {
+  std::vector<json> results{};
+  bool              found = false;
+  for (std::size_t shard = 0U; shard < nrOfTasks; shard++) {
+    const auto file = resultFile(directory, shard);
+    if (std::filesystem::exists(file)) {
+      results.emplace_back(readJsonFile(file));
+      found = found || isNotEquivalent(results.back());
+    }
+  }
+  const bool complete = found || results.size() == nrOfTasks;
+  mergeResults(std::move(results));
+  if (found) {
+    std::ofstream(cancelFile(directory)) << "counterexample found\n";
+  } else if (!complete) {
+    stats.result        = EquivalenceResult::Unknown;
+    stats.equal         = false;
+    stats.unknownReason = "waiting for shard results";
+  }
+  return complete;
+}
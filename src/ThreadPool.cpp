@@ -0,0 +1,49 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(std::size_t nrOfThreads) {
+  if (nrOfThreads == 0U) {
+    nrOfThreads =
+        std::max<std::size_t>(std::thread::hardware_concurrency(), 1U);
+  }
+  workers.reserve(nrOfThreads);
+  for (std::size_t i = 0U; i < nrOfThreads; i++) {
+    workers.emplace_back([this]() { work(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    const std::lock_guard lock(mutex);
+    stopping = true;
+  }
+  taskAvailable.notify_all();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+  {
+    const std::lock_guard lock(mutex);
+    tasks.emplace(std::move(task));
+  }
+  taskAvailable.notify_one();
+}
+
+void ThreadPool::work() {
+  while (true) {
+    std::function<void()> task{};
+    {
+      std::unique_lock lock(mutex);
+      taskAvailable.wait(lock, [this]() { return stopping || !tasks.empty(); });
+      if (tasks.empty()) {
+        return;
+      }
+      task = std::move(tasks.front());
+      tasks.pop();
+    }
+    task();
+  }
+}
@@ -0,0 +1,94 @@
+#include "Z3ContextPool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <map>
+#include <memory>
+#include <stdexcept>
+
+namespace {
+// constants above are created on demand, since the ids of the generators
+// are dense, this only affects very large instances
+constexpr std::uint64_t MAX_CACHED_VALUE = 1U << 16U;
+
+std::atomic<std::size_t> maxReuses{1024U};
+} // namespace
+
+struct Z3ContextPool::Context {
+  std::unique_ptr<z3::context> ctx;
+  // destroyed before the context they belong to
+  std::map<unsigned, z3::expr_vector> values;
+  std::size_t                         nrOfChecks = 0U;
+  std::size_t                         nrOfLeases = 0U;
+
+  void reset() {
+    values.clear();
+    ctx.reset();
+    nrOfChecks = 0U;
+  }
+};
+
+Z3ContextPool::Context& Z3ContextPool::threadContext() {
+  thread_local Context context{};
+  return context;
+}
+
+Z3ContextPool::Lease::Lease() : context(&threadContext()) {
+  if (context->nrOfLeases == 0U && context->ctx &&
+      context->nrOfChecks >= maxReuses.load()) {
+    context->reset();
+  }
+  if (!context->ctx) {
+    context->ctx = std::make_unique<z3::context>();
+  }
+  context->nrOfLeases++;
+}
+
+Z3ContextPool::Lease::Lease(Owned)
+    : context(nullptr), owned(std::make_unique<Context>()) {
+  context      = owned.get();
+  context->ctx = std::make_unique<z3::context>();
+}
+
+Z3ContextPool::Lease::~Lease() {
+  if (owned) {
+    return; // destroyed together with the lease
+  }
+  context->nrOfLeases--;
+  context->nrOfChecks++;
+  if (context->nrOfLeases == 0U && context->nrOfChecks >= maxReuses.load()) {
+    context->reset();
+  }
+}
+
+z3::context& Z3ContextPool::Lease::ctx() { return *context->ctx; }
+
+z3::expr Z3ContextPool::Lease::value(std::uint64_t value, unsigned bitwidth) {
+  if (value >= MAX_CACHED_VALUE) {
+    return context->ctx->bv_val(value, bitwidth);
+  }
+  auto& values =
+      context->values.try_emplace(bitwidth, *context->ctx).first->second;
+  for (auto next = static_cast<std::uint64_t>(values.size()); next <= value;
+       next++) {
+    values.push_back(context->ctx->bv_val(next, bitwidth));
+  }
+  return values[static_cast<unsigned>(value)];
+}
+
+void Z3ContextPool::setMaxReuses(std::size_t reuses) { maxReuses = reuses; }
+
+z3::expr Z3ContextPool::variable(z3::context& ctx, std::string_view prefix,
+                                 std::size_t index, unsigned bitwidth) {
+  // room for the prefix, 20 digits, and the terminating null character
+  std::array<char, 64> name{};
+  if (prefix.size() > name.size() - 21U) {
+    throw std::invalid_argument("Variable prefix too long");
+  }
+  auto* end = std::copy(prefix.begin(), prefix.end(), name.begin());
+  end       = std::to_chars(end, name.end() - 1, index).ptr;
+  *end      = '\0';
+  return ctx.bv_const(name.data(), bitwidth);
+}
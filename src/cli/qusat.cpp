@@ -0,0 +1,123 @@
+#include "BatchRunner.hpp"
+#include "ShardedChecker.hpp"
+
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+void printUsage(std::ostream& os) {
+  os << "usage: qusat [options] <manifest>\n"
+        "\n"
+        "Checks the equivalence of the circuit pairs in a JSON Lines manifest\n"
+        "and writes one JSON line per pair once its check has finished. A\n"
+        "manifest of - is read from the standard input.\n"
+        "\n"
+        "  -j, --jobs <n>       number of parallel checks (default: all "
+        "cores)\n"
+        "  -o, --output <file>  write the results to file instead of stdout\n"
+        "  --timeout <ms>       time limit per check\n"
+        "  --memory <mb>        memory limit per check\n"
+        "  --max-t-count <n>    maximum T-count per circuit (default: 16)\n"
+        "  --shard-task <file>  check a shard task of a sharded check instead\n"
+        "  -h, --help           show this message\n";
+}
+
+std::size_t parseNumber(const std::string& option, const std::string& value) {
+  std::size_t end = 0U;
+  try {
+    const auto number = std::stoull(value, &end);
+    if (end == value.size() && value.front() != '-') {
+      return static_cast<std::size_t>(number);
+    }
+  } catch (const std::exception&) {
+  }
+  throw std::invalid_argument("invalid value '" + value + "' for " + option);
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  std::size_t                    nrOfThreads = 0U;
+  std::size_t                    maxTCount   = 16U;
+  SatEncoder::Limits             limits{};
+  std::string                    outputFile{};
+  std::string                    manifest{};
+  std::string                    shardTask{};
+  const std::vector<std::string> args(argv + 1, argv + argc);
+  try {
+    for (std::size_t i = 0U; i < args.size(); i++) {
+      const auto& arg   = args[i];
+      const auto  value = [&]() -> const std::string& {
+        if (i + 1U == args.size()) {
+          throw std::invalid_argument("missing value for " + arg);
+        }
+        return args[++i];
+      };
+      if (arg == "-h" || arg == "--help") {
+        printUsage(std::cout);
+        return EXIT_SUCCESS;
+      }
+      if (arg == "-j" || arg == "--jobs") {
+        nrOfThreads = parseNumber(arg, value());
+      } else if (arg == "-o" || arg == "--output") {
+        outputFile = value();
+      } else if (arg == "--timeout") {
+        limits.timeout = parseNumber(arg, value());
+      } else if (arg == "--memory") {
+        limits.memory = parseNumber(arg, value());
+      } else if (arg == "--max-t-count") {
+        maxTCount = parseNumber(arg, value());
+      } else if (arg == "--shard-task") {
+        shardTask = value();
+      } else if (arg.size() > 1U && arg.front() == '-') {
+        throw std::invalid_argument("unknown option " + arg);
+      } else if (manifest.empty()) {
+        manifest = arg;
+      } else {
+        throw std::invalid_argument("more than one manifest given");
+      }
+    }
+    if (manifest.empty() && shardTask.empty()) {
+      throw std::invalid_argument("no manifest given");
+    }
+  } catch (const std::invalid_argument& e) {
+    std::cerr << "qusat: " << e.what() << "\n\n";
+    printUsage(std::cerr);
+    return 2;
+  }
+
+  if (!shardTask.empty()) {
+    // worker of ShardedChecker::setWorkerCommand, cancelled tasks are skipped
+    try {
+      ShardedChecker::runShardTask(shardTask);
+      return EXIT_SUCCESS;
+    } catch (const std::exception& e) {
+      std::cerr << "qusat: " << e.what() << '\n';
+      return EXIT_FAILURE;
+    }
+  }
+
+  BatchRunner runner(nrOfThreads);
+  runner.setLimits(limits);
+  runner.setMaxTCount(maxTCount);
+  try {
+    std::ofstream file{};
+    if (!outputFile.empty()) {
+      file.open(outputFile);
+      if (!file.good()) {
+        throw std::runtime_error("Could not write " + outputFile);
+      }
+    }
+    auto&      output = outputFile.empty() ? std::cout : file;
+    const auto errors = manifest == "-" ? runner.run(std::cin, "", output)
+                                        : runner.run(manifest, output);
+    return errors == 0U ? EXIT_SUCCESS : EXIT_FAILURE;
+  } catch (const std::exception& e) {
+    std::cerr << "qusat: " << e.what() << '\n';
+    return EXIT_FAILURE;
+  }
+}
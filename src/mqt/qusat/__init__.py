@@ -18,6 +18,20 @@ if sys.platform == "win32" and sys.version_info > (3, 8, 0) and "Z3_ROOT" in os.
     if bin_path.exists():
         os.add_dll_directory(str(bin_path))
 
-from .pyqusat import check_equivalence
+from .pyqusat import (
+    GATE_DTYPE,
+    GateType,
+    all_computational_basis_inputs,
+    all_stabilizer_inputs,
+    check_equivalence,
+    check_equivalence_async,
+)
 
-__all__ = ["check_equivalence"]
+__all__ = [
+    "GATE_DTYPE",
+    "GateType",
+    "all_computational_basis_inputs",
+    "all_stabilizer_inputs",
+    "check_equivalence",
+    "check_equivalence_async",
+]
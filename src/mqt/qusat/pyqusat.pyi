@@ -1,9 +1,58 @@
 import os
-from typing import Any
+from concurrent.futures import Future
+from typing import Any, ClassVar
 
+import numpy as np
+import numpy.typing as npt
 from qiskit import QuantumCircuit
 
+GATE_DTYPE: np.dtype[np.void]
+
+class GateType:
+    I: ClassVar[GateType]
+    H: ClassVar[GateType]
+    S: ClassVar[GateType]
+    Sdg: ClassVar[GateType]
+    X: ClassVar[GateType]
+    Y: ClassVar[GateType]
+    Z: ClassVar[GateType]
+    T: ClassVar[GateType]
+    Tdg: ClassVar[GateType]
+    def __int__(self) -> int: ...
+
 def check_equivalence(
-    circ1: str | os.PathLike[str] | QuantumCircuit,
-    circ2: str | os.PathLike[str] | QuantumCircuit,
+    circ1: str | os.PathLike[str] | QuantumCircuit | npt.NDArray[np.void],
+    circ2: str | os.PathLike[str] | QuantumCircuit | npt.NDArray[np.void],
+    inputs: list[str] = ...,
+    portfolio: bool = ...,
+    timeout: int = ...,
+    memory_limit: int = ...,
+    preprocessing_timeout: int = ...,
+    preprocessing_memory_limit: int = ...,
+    solver_timeout: int = ...,
+    solver_memory_limit: int = ...,
+    cache: bool = ...,
+    cache_directory: str | os.PathLike[str] = ...,
+    num_qubits: int = ...,
+    max_t_count: int = ...,
 ) -> dict[str, Any]: ...
+
+def check_equivalence_async(
+    circ1: str | os.PathLike[str] | QuantumCircuit | npt.NDArray[np.void],
+    circ2: str | os.PathLike[str] | QuantumCircuit | npt.NDArray[np.void],
+    inputs: list[str] = ...,
+    portfolio: bool = ...,
+    timeout: int = ...,
+    memory_limit: int = ...,
+    preprocessing_timeout: int = ...,
+    preprocessing_memory_limit: int = ...,
+    solver_timeout: int = ...,
+    solver_memory_limit: int = ...,
+    cache: bool = ...,
+    cache_directory: str | os.PathLike[str] = ...,
+    num_qubits: int = ...,
+    max_t_count: int = ...,
+) -> Future[dict[str, Any]]: ...
+
+def all_computational_basis_inputs(num_qubits: int) -> list[str]: ...
+def all_stabilizer_inputs(num_qubits: int, k: int) -> list[str]: ...
@@ -5,8 +5,10 @@
  */
 
 #include "SatEncoder.hpp"
+#include "ThreadPool.hpp"
 #include "python/qiskit/QuantumCircuit.hpp"
 
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -24,35 +26,286 @@ void importQuantumComputation(qc::QuantumComputation& qc,
   }
 }
 
-py::dict checkEquivalence(const py::object& circ1, const py::object& circ2,
-                          const std::vector<std::string>& inputs = {}) {
-  qc::QuantumComputation qc1{}, qc2{};
-  py::dict               results{};
+// structured NumPy array with the fields of CliffordGate. Arrays with this
+// dtype are read in place, others are converted
+using GateArray =
+    py::array_t<CliffordGate, py::array::c_style | py::array::forcecast>;
+
+// circuit given either as a gate array or as a circuit/file that is imported
+struct ImportedCircuit {
+  std::optional<GateArray>                    array{};
+  std::optional<SatEncoder::ConvertedCircuit> converted{}; // if not an array
+  std::size_t                                 nrOfQubits = 0U;
+
+  // circuits of fewer qubits are extended by ancillas by the encoder
+  [[nodiscard]] CliffordCircuit view(std::size_t qubits) const {
+    if (array) {
+      return {qubits, array->data(), static_cast<std::size_t>(array->size())};
+    }
+    return converted->view();
+  }
+};
+
+ImportedCircuit importGateArray(const py::object& circ) {
+  ImportedCircuit result{};
+  result.array = GateArray::ensure(circ);
+  if (!*result.array || result.array->ndim() != 1) {
+    throw std::invalid_argument("Gate arrays must be one-dimensional with "
+                                "dtype GATE_DTYPE");
+  }
+  for (const auto& gate : result.view(0U)) {
+    result.nrOfQubits =
+        std::max({result.nrOfQubits, static_cast<std::size_t>(gate.target) + 1U,
+                  static_cast<std::size_t>(gate.control + 1)});
+  }
+  return result;
+}
+
+ImportedCircuit importCircuit(const py::object& circ) {
+  if (py::isinstance<py::array>(circ)) {
+    return importGateArray(circ);
+  }
+  qc::QuantumComputation qc{};
+  importQuantumComputation(qc, circ);
+  auto converted = SatEncoder::convert(qc);
+  if (!converted) {
+    throw std::invalid_argument("Circuit is not a Clifford circuit");
+  }
+  return {std::nullopt, std::move(converted), qc.getNqubits()};
+}
+
+std::shared_ptr<EncodingCache> getEncodingCache(const std::string& directory) {
+  // one cache per directory that is shared by all calls of this process
+  static std::mutex                                            mutex;
+  static std::map<std::string, std::shared_ptr<EncodingCache>> caches;
+  const std::lock_guard                                        lock(mutex);
+  auto& cache = caches[directory];
+  if (cache == nullptr) {
+    cache = std::make_shared<EncodingCache>(128U, directory);
+  }
+  return cache;
+}
+
+// a single equivalence check. Python objects are only touched while holding
+// the GIL, run() is called without it
+struct EquivalenceCheck {
+  qc::QuantumComputation   qc1{}, qc2{};
+  ImportedCircuit          gates1{}, gates2{};
+  bool                     useGates   = false;
+  std::size_t              nrOfQubits = 0U;
+  std::vector<std::string> inputs{};
+  SatEncoder               encoder{};
+  bool                     equivalent = false;
+  std::string              error{};
+  py::object               future{}; // only set for asynchronous checks
+
+  void run() {
+    try {
+      if (useGates) {
+        equivalent = encoder.testEqual(gates1.view(nrOfQubits),
+                                       gates2.view(nrOfQubits), inputs);
+      } else {
+        equivalent = encoder.testEqual(qc1, qc2, inputs);
+      }
+    } catch (std::exception const& e) {
+      error = e.what();
+    }
+  }
+
+  [[nodiscard]] py::dict results() const {
+    py::dict results{};
+    if (!error.empty()) {
+      py::print("Could not check equivalence: ", error);
+      return results;
+    }
+    const auto& stats         = encoder.getStats();
+    results["equivalent"]     = equivalent;
+    results["result"]         = nl::json(stats.result).get<std::string>();
+    results["reason"]         = stats.unknownReason;
+    results["statistics"]     = stats;
+    results["counterexample"] = py::none();
+    if (const auto& counterexample = encoder.getCounterexample()) {
+      results["counterexample"] = py::dict(
+          "input"_a                 = counterexample->input,
+          "input_generators"_a      = counterexample->inputGenerators,
+          "output_generators_one"_a = counterexample->outputGeneratorsOne,
+          "output_generators_two"_a = counterexample->outputGeneratorsTwo,
+          "differing_generators"_a  = counterexample->differingGenerators);
+    }
+    return results;
+  }
+};
+
+// imports the circuits and configures the encoder, requires the GIL
+std::unique_ptr<EquivalenceCheck> prepareCheck(
+    const py::object& circ1, const py::object& circ2,
+    const std::vector<std::string>& inputs, bool portfolio,
+    std::size_t timeout, std::size_t memoryLimit,
+    std::size_t preprocessingTimeout, std::size_t preprocessingMemoryLimit,
+    std::size_t solverTimeout, std::size_t solverMemoryLimit, bool cache,
+    const std::string& cacheDirectory, std::size_t numQubits,
+    std::size_t maxTCount) {
+  auto check = std::make_unique<EquivalenceCheck>();
+  // circuits given as gate arrays bypass the QuantumComputation entirely
+  check->useGates =
+      py::isinstance<py::array>(circ1) || py::isinstance<py::array>(circ2);
   try {
-    importQuantumComputation(qc1, circ1);
-    importQuantumComputation(qc2, circ2);
+    if (check->useGates) {
+      check->gates1     = importCircuit(circ1);
+      check->gates2     = importCircuit(circ2);
+      check->nrOfQubits = std::max(
+          {numQubits, check->gates1.nrOfQubits, check->gates2.nrOfQubits});
+    } else {
+      importQuantumComputation(check->qc1, circ1);
+      importQuantumComputation(check->qc2, circ2);
+    }
   } catch (std::exception const& e) {
     py::print("Could not import circuitt: ", e.what());
-    return {};
+    return nullptr;
   }
+  check->inputs = inputs;
 
-  SatEncoder encoder{};
-  try {
-    results["equivalent"] = encoder.testEqual(qc1, qc2, inputs);
-  } catch (std::exception const& e) {
-    py::print("Could not check equivalence: ", e.what());
+  auto& encoder = check->encoder;
+  if (portfolio) {
+    encoder.setPortfolio(SatEncoder::defaultPortfolio());
+  }
+  if (cache || !cacheDirectory.empty()) {
+    encoder.setCache(getEncodingCache(cacheDirectory));
+  }
+  encoder.setLimits({timeout, memoryLimit, preprocessingTimeout,
+                     preprocessingMemoryLimit, solverTimeout,
+                     solverMemoryLimit});
+  encoder.setMaxTCount(maxTCount);
+  return check;
+}
+
+py::dict checkEquivalence(
+    const py::object& circ1, const py::object& circ2,
+    const std::vector<std::string>& inputs = {}, bool portfolio = false,
+    std::size_t timeout = 0U, std::size_t memoryLimit = 0U,
+    std::size_t preprocessingTimeout = 0U,
+    std::size_t preprocessingMemoryLimit = 0U, std::size_t solverTimeout = 0U,
+    std::size_t solverMemoryLimit = 0U, bool cache = false,
+    const std::string& cacheDirectory = "", std::size_t numQubits = 0U,
+    std::size_t maxTCount = 16U) {
+  const auto check = prepareCheck(
+      circ1, circ2, inputs, portfolio, timeout, memoryLimit,
+      preprocessingTimeout, preprocessingMemoryLimit, solverTimeout,
+      solverMemoryLimit, cache, cacheDirectory, numQubits, maxTCount);
+  if (check == nullptr) {
     return {};
   }
-  results["statistics"] = encoder.getStats();
-  return results;
+  {
+    const py::gil_scoped_release release;
+    check->run();
+  }
+  return check->results();
+}
+
+ThreadPool& getThreadPool() {
+  // never destroyed, joining the workers during interpreter shutdown could
+  // deadlock on the GIL
+  static auto* pool = new ThreadPool();
+  return *pool;
+}
+
+py::object checkEquivalenceAsync(
+    const py::object& circ1, const py::object& circ2,
+    const std::vector<std::string>& inputs = {}, bool portfolio = false,
+    std::size_t timeout = 0U, std::size_t memoryLimit = 0U,
+    std::size_t preprocessingTimeout = 0U,
+    std::size_t preprocessingMemoryLimit = 0U, std::size_t solverTimeout = 0U,
+    std::size_t solverMemoryLimit = 0U, bool cache = false,
+    const std::string& cacheDirectory = "", std::size_t numQubits = 0U,
+    std::size_t maxTCount = 16U) {
+  auto future = py::module_::import("concurrent.futures").attr("Future")();
+  auto check  = prepareCheck(
+      circ1, circ2, inputs, portfolio, timeout, memoryLimit,
+      preprocessingTimeout, preprocessingMemoryLimit, solverTimeout,
+      solverMemoryLimit, cache, cacheDirectory, numQubits, maxTCount);
+  future.attr("set_running_or_notify_cancel")();
+  if (check == nullptr) {
+    future.attr("set_result")(py::dict());
+    return future;
+  }
+  check->future = future;
+  // the task owns the check and destroys it while holding the GIL, since
+  // it contains Python objects
+  getThreadPool().submit([task = check.release()]() {
+    task->run();
+    const py::gil_scoped_acquire acquire;
+    try {
+      task->future.attr("set_result")(task->results());
+    } catch (py::error_already_set& e) {
+      e.discard_as_unraisable("check_equivalence_async");
+    }
+    delete task;
+  });
+  return future;
 }
 
 PYBIND11_MODULE(pyqusat, m) {
   m.doc() =
       "Python interface for the MQT QuSAT quantum circuit satisfiability tool";
 
+  PYBIND11_NUMPY_DTYPE(CliffordGate, type, control, target);
+  m.attr("GATE_DTYPE") = py::dtype::of<CliffordGate>();
+  py::enum_<GateType>(m, "GateType")
+      .value("I", GateType::I)
+      .value("H", GateType::H)
+      .value("S", GateType::S)
+      .value("Sdg", GateType::Sdg)
+      .value("X", GateType::X)
+      .value("Y", GateType::Y)
+      .value("Z", GateType::Z)
+      .value("T", GateType::T)
+      .value("Tdg", GateType::Tdg);
+
   m.def("check_equivalence", &checkEquivalence,
         "Check the equivalence of two clifford circuits for the given inputs."
-        "If no inputs are given, the all zero state is used as input.",
-        "circ1"_a, "circ2"_a, "inputs"_a = std::vector<std::string>());
+        "If no inputs are given, the all zero state is used as input."
+        "If portfolio is set, several solver configurations are run in "
+        "parallel and the first answer is used."
+        "Time limits are given in milliseconds and memory limits in "
+        "megabytes, zero means unlimited. If a limit is hit, the result is "
+        "'unknown' and the reason is reported. If the circuits are not "
+        "equivalent, a distinguishing input and the differing output "
+        "generators are returned as counterexample. If cache is set, circuit "
+        "encodings are reused across calls. If a cache directory is given, "
+        "they are also persisted on disk. Circuits may also be given as "
+        "NumPy arrays of dtype GATE_DTYPE with fields (type, control, "
+        "target), where a CNOT is an X gate with a control >= 0 and "
+        "control is -1 otherwise. Such arrays are read in place. The number "
+        "of qubits is inferred from the gates unless num_qubits is larger. "
+        "Besides Clifford gates, up to max_t_count T/Tdg gates per circuit "
+        "are supported. The GIL is released while the circuits are checked.",
+        "circ1"_a, "circ2"_a, "inputs"_a = std::vector<std::string>(),
+        "portfolio"_a = false, "timeout"_a = 0U, "memory_limit"_a = 0U,
+        "preprocessing_timeout"_a = 0U, "preprocessing_memory_limit"_a = 0U,
+        "solver_timeout"_a = 0U, "solver_memory_limit"_a = 0U,
+        "cache"_a = false, "cache_directory"_a = "", "num_qubits"_a = 0U,
+        "max_t_count"_a = 16U);
+
+  m.def("check_equivalence_async", &checkEquivalenceAsync,
+        "Same as check_equivalence, but runs the check on a native thread "
+        "pool and immediately returns a concurrent.futures.Future for the "
+        "result. Use asyncio.wrap_future to await it. Gate arrays must not be "
+        "modified until the future is done.",
+        "circ1"_a, "circ2"_a, "inputs"_a = std::vector<std::string>(),
+        "portfolio"_a = false, "timeout"_a = 0U, "memory_limit"_a = 0U,
+        "preprocessing_timeout"_a = 0U, "preprocessing_memory_limit"_a = 0U,
+        "solver_timeout"_a = 0U, "solver_memory_limit"_a = 0U,
+        "cache"_a = false, "cache_directory"_a = "", "num_qubits"_a = 0U,
+        "max_t_count"_a = 16U);
+
+  m.def("all_computational_basis_inputs",
+        &SatEncoder::allComputationalBasisInputs,
+        "Inputs that symbolically cover all computational basis states of a "
+        "circuit by propagating each Z_i individually.",
+        "num_qubits"_a);
+
+  m.def("all_stabilizer_inputs", &SatEncoder::allStabilizerInputs,
+        "Inputs that symbolically cover all stabilizer states on the first k "
+        "qubits (and all computational basis states on the others).",
+        "num_qubits"_a, "k"_a);
 }
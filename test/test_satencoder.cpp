@@ -1,5 +1,9 @@
+#include "BatchRunner.hpp"
 #include "CircuitOptimizer.hpp"
 #include "SatEncoder.hpp"
+#include "ShardedChecker.hpp"
+#include "ThreadPool.hpp"
+#include "Z3ContextPool.hpp"
 #include "algorithms/RandomCliffordCircuit.hpp"
 
 #include <ctime>
@@ -7,13 +11,38 @@
 #define localtime_r(a, b) (localtime_s(b, a) == 0 ? b : NULL)
 #endif
 
+#include <atomic>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <gtest/gtest.h>
 #include <locale>
+#include <map>
+#include <sstream>
+#include <thread>
 
 class SatEncoderTest : public testing::TestWithParam<std::string> {};
 
+namespace {
+CliffordGate gate(GateType type, std::int32_t control, std::int32_t target) {
+  return CliffordGate{static_cast<std::uint8_t>(type), control, target};
+}
+
+// 10 rounds of H on each of 4 qubits followed by a CNOT chain
+std::vector<CliffordGate> hadamardCnotRounds() {
+  std::vector<CliffordGate> gates{};
+  for (std::size_t round = 0U; round < 10U; round++) {
+    for (std::int32_t qubit = 0; qubit < 4; qubit++) {
+      gates.emplace_back(gate(GateType::H, -1, qubit));
+    }
+    for (std::int32_t qubit = 0; qubit < 3; qubit++) {
+      gates.emplace_back(gate(GateType::X, qubit, qubit + 1));
+    }
+  }
+  return gates;
+}
+} // namespace
+
 TEST_F(SatEncoderTest, CheckEqualWhenEqualRandomCircuits) {
   std::random_device        rd;
   std::mt19937              gen(rd());
@@ -88,6 +117,970 @@ TEST_F(SatEncoderTest, CheckSATConstructionWithSmallCircuit) {
   EXPECT_EQ(result, true);
 }
 
+TEST_F(SatEncoderTest, CheckEqualWithPortfolio) {
+  std::random_device        rd;
+  std::mt19937              gen(rd());
+  qc::RandomCliffordCircuit circOne(5, 10, gen());
+  qc::CircuitOptimizer::flattenOperations(circOne);
+  auto circTwo = circOne;
+
+  SatEncoder satEncoder;
+  satEncoder.setPortfolio(SatEncoder::defaultPortfolio());
+  bool result = satEncoder.testEqual(circOne, circTwo);
+  EXPECT_EQ(result, true);
+  EXPECT_FALSE(satEncoder.getStats().solverConfiguration.empty());
+}
+
+TEST_F(SatEncoderTest, CheckNotEqualWithPortfolio) {
+  qc::QuantumComputation circOne(2);
+  circOne.h(0);
+  circOne.emplace_back<qc::StandardOperation>(2U, qc::Control{0}, 1U,
+                                             qc::OpType::X);
+  auto circTwo = circOne;
+  circTwo.s(1);
+  circTwo.h(1);
+
+  SatEncoder satEncoder;
+  satEncoder.setPortfolio({{"sat", SatEncoder::SolverBackend::SAT, 0U},
+                           {"bv", SatEncoder::SolverBackend::BitVector, 1U}});
+  bool result = satEncoder.testEqual(circOne, circTwo);
+  EXPECT_EQ(result, false);
+  const auto& winner = satEncoder.getStats().solverConfiguration;
+  EXPECT_TRUE(winner == "sat" || winner == "bv");
+  EXPECT_TRUE(satEncoder.getCounterexample().has_value());
+}
+
+TEST_F(SatEncoderTest, CheckResultReported) {
+  std::random_device        rd;
+  std::mt19937              gen(rd());
+  qc::RandomCliffordCircuit circOne(3, 5, gen());
+  qc::CircuitOptimizer::flattenOperations(circOne);
+  auto circTwo = circOne;
+
+  SatEncoder satEncoder;
+  satEncoder.setLimits({60000U, 0U, 0U, 0U, 0U, 0U});
+  bool result = satEncoder.testEqual(circOne, circTwo);
+  EXPECT_EQ(result, true);
+  EXPECT_EQ(satEncoder.getStats().result, EquivalenceResult::Equivalent);
+  EXPECT_TRUE(satEncoder.getStats().unknownReason.empty());
+}
+
+TEST_F(SatEncoderTest, CheckUnknownWhenPreprocessingMemoryExceeded) {
+  std::random_device        rd;
+  std::mt19937              gen(rd());
+  qc::RandomCliffordCircuit circOne(128, 100, gen());
+  qc::CircuitOptimizer::flattenOperations(circOne);
+  auto circTwo = circOne;
+
+  SatEncoder satEncoder;
+  // only verified generators are stored during preprocessing
+  satEncoder.setVerifyGenerators(true);
+  EXPECT_TRUE(satEncoder.testEqual(circOne, circTwo));
+
+  // the result of the previous call is not reported again
+  SatEncoder::Limits limits{};
+  limits.preprocMemory = 1U;
+  satEncoder.setLimits(limits);
+  bool result = satEncoder.testEqual(circOne, circTwo);
+  EXPECT_EQ(result, false);
+  EXPECT_EQ(satEncoder.getStats().result, EquivalenceResult::Unknown);
+  EXPECT_EQ(satEncoder.getStats().unknownReason,
+            "preprocessing memory limit exceeded");
+  EXPECT_FALSE(satEncoder.getStats().equal);
+  EXPECT_FALSE(satEncoder.to_json().at("equivalent").get<bool>());
+}
+
+TEST_F(SatEncoderTest, CheckCounterexampleWhenNotEqual) {
+  qc::QuantumComputation circOne(2);
+  circOne.h(0);
+  circOne.h(1);
+  qc::QuantumComputation circTwo(2);
+  circTwo.h(0);
+  circTwo.s(1);
+
+  SatEncoder               satEncoder;
+  std::vector<std::string> inputs{"zz", "xz"};
+  bool result = satEncoder.testEqual(circOne, circTwo, inputs);
+  EXPECT_EQ(result, false);
+  ASSERT_TRUE(satEncoder.getCounterexample().has_value());
+  const auto& counterexample = *satEncoder.getCounterexample();
+  EXPECT_TRUE(counterexample.input == "zz" || counterexample.input == "xz");
+  EXPECT_EQ(counterexample.differingGenerators, std::vector<std::size_t>{1U});
+  EXPECT_EQ(counterexample.outputGeneratorsOne.at(1), "+IX");
+  EXPECT_EQ(counterexample.outputGeneratorsTwo.at(1), "+IZ");
+}
+
+TEST_F(SatEncoderTest, CheckNoCounterexampleWhenEqual) {
+  std::random_device        rd;
+  std::mt19937              gen(rd());
+  qc::RandomCliffordCircuit circOne(3, 5, gen());
+  qc::CircuitOptimizer::flattenOperations(circOne);
+  auto circTwo = circOne;
+
+  SatEncoder satEncoder;
+  EXPECT_TRUE(satEncoder.testEqual(circOne, circTwo));
+  EXPECT_FALSE(satEncoder.getCounterexample().has_value());
+}
+
+TEST_F(SatEncoderTest, CheckCachedEncodingsAreReused) {
+  std::random_device        rd;
+  std::mt19937              gen(rd());
+  qc::RandomCliffordCircuit circOne(4, 10, gen());
+  qc::CircuitOptimizer::flattenOperations(circOne);
+  auto circTwo   = circOne;
+  auto circThree = circOne;
+  circThree.h(0);
+
+  const auto directory =
+      std::filesystem::temp_directory_path() /
+      ("qusat-cache-" + std::to_string(std::random_device{}()));
+  const std::vector<std::string> inputs{"zx", "Yz"};
+  {
+    auto       cache = std::make_shared<EncodingCache>(8U, directory.string());
+    SatEncoder satEncoder;
+    satEncoder.setCache(cache);
+    EXPECT_TRUE(satEncoder.testEqual(circOne, circTwo, inputs));
+    EXPECT_EQ(satEncoder.getStats().cacheHits, 1U);
+
+    SatEncoder other;
+    other.setCache(cache);
+    EXPECT_FALSE(other.testEqual(circThree, circOne, inputs));
+    EXPECT_EQ(other.getStats().cacheHits, 1U);
+    EXPECT_EQ(cache->size(), 2U);
+  }
+  {
+    // a new cache on the same directory is served from disk
+    auto       cache = std::make_shared<EncodingCache>(8U, directory.string());
+    SatEncoder satEncoder;
+    satEncoder.setCache(cache);
+    EXPECT_FALSE(satEncoder.testEqual(circOne, circThree, inputs));
+    EXPECT_EQ(satEncoder.getStats().cacheHits, 2U);
+    EXPECT_TRUE(satEncoder.getCounterexample().has_value());
+  }
+  {
+    // Pauli sums cannot be stored on disk and are only kept in memory
+    qc::QuantumComputation withT(2);
+    withT.h(0);
+    withT.t(0);
+    withT.h(0);
+    auto       copy  = withT;
+    auto       cache = std::make_shared<EncodingCache>(8U, directory.string());
+    SatEncoder satEncoder;
+    satEncoder.setCache(cache);
+    testing::internal::CaptureStderr();
+    EXPECT_TRUE(satEncoder.testEqual(withT, copy, {"zz"}));
+    EXPECT_EQ(testing::internal::GetCapturedStderr(), "");
+    EXPECT_EQ(satEncoder.getStats().cacheHits, 1U);
+    EXPECT_EQ(std::distance(std::filesystem::directory_iterator(directory),
+                            std::filesystem::directory_iterator{}),
+              2);
+  }
+  std::filesystem::remove_all(directory);
+}
+
+TEST_F(SatEncoderTest, CheckCacheKeyCollisionsAreDetected) {
+  const std::vector<CliffordGate> gatesOne{{1U, -1, 0}, {4U, 0, 1}};
+  const std::vector<CliffordGate> gatesTwo{{1U, -1, 1}, {4U, 1, 0}};
+  const CliffordCircuit           circOne{2U, gatesOne.data(), gatesOne.size()};
+  const CliffordCircuit           circTwo{2U, gatesTwo.data(), gatesTwo.size()};
+  const std::vector<std::string>  inputs{"zz"};
+  const auto contentOne = EncodingCache::content(circOne, inputs);
+  const auto contentTwo = EncodingCache::content(circTwo, inputs);
+  EXPECT_NE(contentOne, EncodingCache::content(circOne, {"zx"}));
+
+  const auto directory =
+      std::filesystem::temp_directory_path() /
+      ("qusat-collision-" + std::to_string(std::random_device{}()));
+  {
+    // an entry of circuit one stored under a colliding key of circuit two
+    EncodingCache  cache(8U, directory.string());
+    CachedEncoding encoding{};
+    encoding.nrOfQubits = 2U;
+    encoding.nrOfGates  = gatesOne.size();
+    encoding.content    = contentOne;
+    cache.insert("collision", encoding);
+    EXPECT_EQ(cache.find("collision", contentTwo), nullptr);
+    EXPECT_NE(cache.find("collision", contentOne), nullptr);
+  }
+  {
+    EncodingCache cache(8U, directory.string());
+    EXPECT_EQ(cache.find("collision", contentTwo), nullptr);
+    EXPECT_NE(cache.find("collision", contentOne), nullptr);
+  }
+  std::filesystem::remove_all(directory);
+}
+
+TEST_F(SatEncoderTest, CheckEqualFromPreprocessedFiles) {
+  std::random_device        rd;
+  std::mt19937              gen(rd());
+  qc::RandomCliffordCircuit circOne(6, 10, gen());
+  qc::CircuitOptimizer::flattenOperations(circOne);
+  auto circTwo   = circOne;
+  auto circThree = circOne;
+  circThree.s(5);
+  circThree.h(5);
+
+  const auto prefix =
+      std::filesystem::temp_directory_path() /
+      ("qusat-encoding-" + std::to_string(std::random_device{}()));
+  const auto fileOne   = prefix.string() + "-1.qsat";
+  const auto fileTwo   = prefix.string() + "-2.qsat";
+  const auto fileThree = prefix.string() + "-3.qsat";
+  const std::vector<std::string> inputs{"zzzzzz", "xzzzzY"};
+  EXPECT_TRUE(SatEncoder().preprocessToFile(circOne, inputs, fileOne));
+  EXPECT_TRUE(SatEncoder().preprocessToFile(circTwo, inputs, fileTwo));
+  EXPECT_TRUE(SatEncoder().preprocessToFile(circThree, inputs, fileThree));
+
+  const MappedEncoding one(fileOne);
+  const MappedEncoding two(fileTwo);
+  const MappedEncoding three(fileThree);
+  EXPECT_EQ(one.view().header().nrOfQubits, 6U);
+  EXPECT_EQ(one.view().header().nrOfInputs, 2U);
+
+  SatEncoder satEncoder;
+  EXPECT_TRUE(satEncoder.testEqual(one.view(), two.view()));
+  SatEncoder other;
+  EXPECT_FALSE(other.testEqual(one.view(), three.view()));
+  EXPECT_TRUE(other.getCounterexample().has_value());
+
+  std::filesystem::remove(fileOne);
+  std::filesystem::remove(fileTwo);
+  std::filesystem::remove(fileThree);
+
+  // Pauli sums and mixed symbolic and state inputs have no fixed row size
+  qc::QuantumComputation withT(2);
+  withT.h(0);
+  withT.t(0);
+  withT.h(0);
+  SatEncoder rejected;
+  EXPECT_FALSE(rejected.preprocessToFile(withT, {"zz"}, fileOne));
+  EXPECT_FALSE(rejected.getStats().unknownReason.empty());
+  EXPECT_FALSE(rejected.preprocessToFile(circTwo, {"zzzzzz", "+XIIIII"},
+                                         fileTwo));
+  EXPECT_FALSE(rejected.getStats().unknownReason.empty());
+  CachedEncoding mixed{};
+  mixed.generators = {{{true, false}}, {{true, false}, {false, true}}};
+  EXPECT_THROW(writeEncoding(fileThree, mixed), std::invalid_argument);
+  for (const auto& entry : std::filesystem::directory_iterator(
+           std::filesystem::temp_directory_path())) {
+    EXPECT_NE(entry.path().string().rfind(prefix.string(), 0U), 0U)
+        << entry.path();
+  }
+}
+
+TEST_F(SatEncoderTest, CheckInvalidEncodingIsRejected) {
+  const std::vector<std::uint64_t> data(16U, 0U);
+  EXPECT_THROW(EncodingView(data.data(), data.size() * sizeof(std::uint64_t)),
+               std::runtime_error);
+
+  // two generators, one input, and two levels with a single mapping each
+  CachedEncoding encoding{};
+  encoding.generators        = {{{true, false}}, {{false, true}}};
+  encoding.inputGeneratorIds = {0U};
+  encoding.generatorMappings = {{{0U, 1U}}, {{1U, 0U}}};
+  std::stringstream ss{};
+  writeEncoding(ss, encoding);
+  const auto                 bytes = ss.str();
+  std::vector<std::uint64_t> valid(bytes.size() / sizeof(std::uint64_t));
+  std::memcpy(valid.data(), bytes.data(), bytes.size());
+  const auto view = [](const std::vector<std::uint64_t>& words) {
+    return EncodingView(words.data(), words.size() * sizeof(std::uint64_t));
+  };
+  EXPECT_EQ(view(valid).toEncoding().generatorMappings,
+            encoding.generatorMappings);
+
+  // header, generators (12, 13), input id (14), level offsets (15 - 17), and
+  // mappings (18 - 21)
+  const std::vector<std::pair<std::size_t, std::uint64_t>> corruptions{
+      {16U, 3U},                 // offset beyond the mappings
+      {15U, 2U},                 // decreasing offsets
+      {14U, 2U},                 // input id out of range
+      {20U, 7U},                 // mapping id out of range
+      {6U, (1ULL << 63U) + 1U}, // generator words wrap to the original size
+      {10U, (1ULL << 63U) + 2U}, // mapping words wrap to the original size
+  };
+  for (const auto& [index, value] : corruptions) {
+    auto corrupt   = valid;
+    corrupt[index] = value;
+    EXPECT_THROW(static_cast<void>(view(corrupt)), std::runtime_error);
+  }
+}
+
+TEST_F(SatEncoderTest, CheckEqualForAllComputationalBasisInputs) {
+  std::random_device        rd;
+  std::mt19937              gen(rd());
+  qc::RandomCliffordCircuit circOne(10, 20, gen());
+  qc::CircuitOptimizer::flattenOperations(circOne);
+  auto circTwo = circOne;
+
+  SatEncoder satEncoder;
+  const auto inputs = SatEncoder::allComputationalBasisInputs(10U);
+  EXPECT_EQ(inputs.size(), 10U);
+  EXPECT_TRUE(satEncoder.testEqual(circOne, circTwo, inputs));
+  EXPECT_EQ(satEncoder.getStats().result, EquivalenceResult::Equivalent);
+}
+
+TEST_F(SatEncoderTest, CheckSymbolicInputsDistinguishPhases) {
+  // S only changes the phase of basis states
+  qc::QuantumComputation circOne(2);
+  circOne.s(0);
+  circOne.h(1);
+  qc::QuantumComputation circTwo(2);
+  circTwo.h(1);
+
+  SatEncoder satEncoder;
+  EXPECT_TRUE(satEncoder.testEqual(
+      circOne, circTwo, SatEncoder::allComputationalBasisInputs(2U)));
+
+  SatEncoder other;
+  EXPECT_FALSE(
+      other.testEqual(circOne, circTwo, SatEncoder::allStabilizerInputs(2U, 1U)));
+  ASSERT_TRUE(other.getCounterexample().has_value());
+  EXPECT_EQ(other.getCounterexample()->input, "xz");
+  EXPECT_EQ(other.getCounterexample()->inputGenerators,
+            std::vector<std::string>{"+XI"});
+}
+
+TEST_F(SatEncoderTest, CheckEqualForGateArrays) {
+  qc::QuantumComputation circOne(2);
+  circOne.h(0);
+  circOne.emplace_back<qc::StandardOperation>(2U, qc::Control{0}, 1U,
+                                              qc::OpType::X);
+  circOne.s(1);
+
+  const auto gates = SatEncoder::toGates(circOne);
+  ASSERT_TRUE(gates.has_value());
+  ASSERT_EQ(gates->size(), 3U);
+  EXPECT_EQ(gates->at(1).control, 0);
+  EXPECT_EQ(gates->at(1).target, 1);
+
+  const std::vector<CliffordGate> same{
+      {static_cast<std::uint8_t>(GateType::H), -1, 0},
+      {static_cast<std::uint8_t>(GateType::X), 0, 1},
+      {static_cast<std::uint8_t>(GateType::S), -1, 1}};
+  const std::vector<CliffordGate> different{
+      {static_cast<std::uint8_t>(GateType::H), -1, 0},
+      {static_cast<std::uint8_t>(GateType::X), 0, 1},
+      {static_cast<std::uint8_t>(GateType::Sdg), -1, 1}};
+  const CliffordCircuit gateCircuit{2U, gates->data(), gates->size()};
+
+  SatEncoder satEncoder;
+  EXPECT_TRUE(satEncoder.testEqual(
+      gateCircuit, {2U, same.data(), same.size()}, {"ZZ", "XZ"}));
+  SatEncoder other;
+  EXPECT_FALSE(other.testEqual(
+      gateCircuit, {2U, different.data(), different.size()}, {}));
+  EXPECT_EQ(other.getStats().result, EquivalenceResult::NotEquivalent);
+
+  const std::vector<CliffordGate> invalid{
+      {static_cast<std::uint8_t>(GateType::H), -1, 2}};
+  SatEncoder third;
+  EXPECT_FALSE(third.testEqual(
+      gateCircuit, {2U, invalid.data(), invalid.size()}, {}));
+  EXPECT_EQ(third.getStats().result, EquivalenceResult::Unknown);
+}
+
+TEST_F(SatEncoderTest, CheckEqualConcurrentlyOnThreadPool) {
+  std::random_device        rd;
+  std::mt19937              gen(rd());
+  qc::RandomCliffordCircuit circOne(3, 5, gen());
+  qc::CircuitOptimizer::flattenOperations(circOne);
+  auto circTwo = circOne;
+
+  auto             cache = std::make_shared<EncodingCache>();
+  std::atomic<int> nrOfEqual{0};
+  {
+    ThreadPool pool(4U);
+    for (int i = 0; i < 16; i++) {
+      pool.submit([&]() {
+        auto       one = circOne;
+        auto       two = circTwo;
+        SatEncoder satEncoder;
+        satEncoder.setCache(cache);
+        if (satEncoder.testEqual(one, two)) {
+          nrOfEqual++;
+        }
+      });
+    }
+  } // waits for all tasks
+  EXPECT_EQ(nrOfEqual, 16);
+  EXPECT_EQ(cache->size(), 1U);
+}
+
+TEST_F(SatEncoderTest, CheckEqualWithShardedInputs) {
+  std::random_device        rd;
+  std::mt19937              gen(rd());
+  qc::RandomCliffordCircuit circOne(4, 5, gen());
+  qc::CircuitOptimizer::flattenOperations(circOne);
+  auto       circTwo = circOne;
+  const auto inputs  = SatEncoder::allStabilizerInputs(4U, 4U);
+
+  const auto shards = ShardedChecker::partition(inputs, 3U);
+  ASSERT_EQ(shards.size(), 3U);
+  EXPECT_EQ(shards[0].size() + shards[1].size() + shards[2].size(),
+            inputs.size());
+
+  ShardedChecker checker(2U);
+  checker.setNrOfShards(3U);
+  EXPECT_TRUE(checker.testEqual(circOne, circTwo, inputs));
+  EXPECT_EQ(checker.getStats().result, EquivalenceResult::Equivalent);
+  EXPECT_EQ(checker.getStats().nrOfShards, 3U);
+  EXPECT_EQ(checker.getStats().nrOfDiffInputStates, inputs.size());
+}
+
+TEST_F(SatEncoderTest, CheckShardsStopAtCounterexample) {
+  qc::QuantumComputation circOne(2);
+  circOne.h(0);
+  circOne.h(1);
+  qc::QuantumComputation circTwo(2);
+  circTwo.h(0);
+  circTwo.s(1);
+
+  ShardedChecker checker(2U);
+  checker.setNrOfShards(4U);
+  EXPECT_FALSE(checker.testEqual(circOne, circTwo,
+                                 SatEncoder::allStabilizerInputs(2U, 2U)));
+  EXPECT_EQ(checker.getStats().result, EquivalenceResult::NotEquivalent);
+  ASSERT_TRUE(checker.getCounterexample().has_value());
+  EXPECT_FALSE(checker.getCounterexample()->differingGenerators.empty());
+}
+
+TEST_F(SatEncoderTest, CheckShardsInSpawnedWorkers) {
+  qc::QuantumComputation circOne(2);
+  circOne.h(0);
+  circOne.h(1);
+  qc::QuantumComputation circTwo(2);
+  circTwo.h(0);
+  circTwo.s(1);
+  auto       circThree = circOne;
+  const auto inputs    = SatEncoder::allStabilizerInputs(2U, 2U);
+
+  // workers that do not write a result leave the check undecided
+  ShardedChecker failing(2U);
+  failing.setNrOfShards(2U);
+  failing.setWorkerCommand({"false"});
+  EXPECT_FALSE(failing.testEqual(circOne, circThree, inputs));
+  EXPECT_EQ(failing.getStats().result, EquivalenceResult::Unknown);
+
+#ifdef QUSAT_CLI
+  ShardedChecker checker(2U);
+  checker.setNrOfShards(4U);
+  checker.setWorkerCommand({QUSAT_CLI, "--shard-task"});
+  EXPECT_TRUE(checker.testEqual(circOne, circThree, inputs));
+  EXPECT_EQ(checker.getStats().nrOfShards, 4U);
+  EXPECT_FALSE(checker.testEqual(circOne, circTwo, inputs));
+  EXPECT_EQ(checker.getStats().result, EquivalenceResult::NotEquivalent);
+  EXPECT_TRUE(checker.getCounterexample().has_value());
+#endif
+}
+
+TEST_F(SatEncoderTest, CheckShardTaskFiles) {
+  qc::QuantumComputation circOne(2);
+  circOne.h(0);
+  circOne.emplace_back<qc::StandardOperation>(2U, qc::Control{0}, 1U,
+                                              qc::OpType::X);
+  auto       circTwo  = circOne;
+  const auto gatesOne = SatEncoder::toGates(circOne);
+  const auto gatesTwo = SatEncoder::toGates(circTwo);
+  ASSERT_TRUE(gatesOne.has_value() && gatesTwo.has_value());
+
+  const auto directory =
+      std::filesystem::temp_directory_path() /
+      ("qusat-shards-" + std::to_string(std::random_device{}()));
+  ShardedChecker writer;
+  writer.setNrOfShards(2U);
+  const auto nrOfTasks = writer.writeShardTasks(
+      directory.string(), {2U, gatesOne->data(), gatesOne->size()},
+      {2U, gatesTwo->data(), gatesTwo->size()},
+      SatEncoder::allComputationalBasisInputs(2U));
+  ASSERT_EQ(nrOfTasks, 2U);
+
+  ShardedChecker collector;
+  EXPECT_TRUE(ShardedChecker::runShardTask(
+      (directory / "shard-0.task.json").string()));
+  EXPECT_FALSE(collector.collectShardResults(directory.string(), nrOfTasks));
+  EXPECT_EQ(collector.getStats().result, EquivalenceResult::Unknown);
+  EXPECT_TRUE(ShardedChecker::runShardTask(
+      (directory / "shard-1.task.json").string()));
+  EXPECT_TRUE(collector.collectShardResults(directory.string(), nrOfTasks));
+  EXPECT_EQ(collector.getStats().result, EquivalenceResult::Equivalent);
+  std::filesystem::remove_all(directory);
+}
+
+TEST_F(SatEncoderTest, CheckEqualWithTGates) {
+  qc::QuantumComputation circOne(2);
+  circOne.h(0);
+  circOne.t(0);
+  circOne.emplace_back<qc::StandardOperation>(2U, qc::Control{0}, 1U,
+                                              qc::OpType::X);
+  circOne.t(0);
+  qc::QuantumComputation circTwo(2);
+  circTwo.h(0);
+  circTwo.emplace_back<qc::StandardOperation>(2U, qc::Control{0}, 1U,
+                                              qc::OpType::X);
+  circTwo.s(0);
+
+  // T commutes with the control of a CNOT and T T == S
+  SatEncoder satEncoder;
+  EXPECT_TRUE(satEncoder.testEqual(circOne, circTwo,
+                                   SatEncoder::allStabilizerInputs(2U, 2U)));
+
+  // T Tdg == I
+  qc::QuantumComputation circThree(1);
+  circThree.h(0);
+  circThree.t(0);
+  circThree.tdg(0);
+  qc::QuantumComputation circFour(1);
+  circFour.h(0);
+  SatEncoder other;
+  EXPECT_TRUE(other.testEqual(circThree, circFour));
+}
+
+TEST_F(SatEncoderTest, CheckNotEqualWithTGates) {
+  qc::QuantumComputation circOne(1);
+  circOne.h(0);
+  circOne.t(0);
+  qc::QuantumComputation circTwo(1);
+  circTwo.h(0);
+  circTwo.tdg(0);
+
+  SatEncoder satEncoder;
+  EXPECT_FALSE(satEncoder.testEqual(circOne, circTwo));
+  EXPECT_EQ(satEncoder.getStats().result, EquivalenceResult::NotEquivalent);
+  ASSERT_TRUE(satEncoder.getCounterexample().has_value());
+  EXPECT_EQ(satEncoder.getCounterexample()->outputGeneratorsOne.at(0),
+            "+0.7071X+0.7071Y");
+  EXPECT_EQ(satEncoder.getCounterexample()->outputGeneratorsTwo.at(0),
+            "+0.7071X-0.7071Y");
+
+  SatEncoder limited;
+  limited.setMaxTCount(0U);
+  EXPECT_FALSE(limited.testEqual(circOne, circOne));
+  EXPECT_EQ(limited.getStats().result, EquivalenceResult::Unknown);
+  EXPECT_EQ(limited.getStats().unknownReason, "T-count limit exceeded");
+
+  // the coefficients stay exact up to the largest supported T-count, which
+  // also bounds higher limits
+  qc::QuantumComputation deep(1);
+  for (std::size_t i = 0U; i < SatEncoder::MAX_T_COUNT; i++) {
+    deep.h(0);
+    deep.t(0);
+  }
+  auto deeper = deep;
+  deeper.h(0);
+  deeper.t(0);
+  SatEncoder unlimited;
+  unlimited.setMaxTCount(1000U);
+  EXPECT_TRUE(unlimited.testEqual(deep, deep));
+  EXPECT_FALSE(unlimited.testEqual(deeper, deeper));
+  EXPECT_EQ(unlimited.getStats().unknownReason, "T-count limit exceeded");
+}
+
+TEST_F(SatEncoderTest, CheckCounterexampleWithVerifiedGenerators) {
+  qc::QuantumComputation circOne(3);
+  circOne.h(0);
+  circOne.emplace_back<qc::StandardOperation>(3U, qc::Control{0}, 1U,
+                                            qc::OpType::X);
+  circOne.s(2);
+  circOne.h(2);
+  qc::QuantumComputation circTwo(3);
+  circTwo.h(0);
+  circTwo.emplace_back<qc::StandardOperation>(3U, qc::Control{0}, 1U,
+                                            qc::OpType::X);
+  circTwo.h(2);
+  circTwo.s(2);
+
+  // a single input, such that the counterexample is unique
+  const std::vector<std::string> inputs{"ZZX"};
+  SatEncoder                     lazy;
+  EXPECT_FALSE(lazy.testEqual(circOne, circTwo, inputs));
+  SatEncoder verified;
+  verified.setVerifyGenerators(true);
+  EXPECT_FALSE(verified.testEqual(circOne, circTwo, inputs));
+
+  // generators of the counterexample are recomputed from the circuits
+  ASSERT_TRUE(lazy.getCounterexample().has_value());
+  ASSERT_TRUE(verified.getCounterexample().has_value());
+  const auto& one = *lazy.getCounterexample();
+  const auto& two = *verified.getCounterexample();
+  EXPECT_EQ(one.input, two.input);
+  EXPECT_EQ(one.inputGenerators, two.inputGenerators);
+  EXPECT_EQ(one.outputGeneratorsOne, two.outputGeneratorsOne);
+  EXPECT_EQ(one.outputGeneratorsTwo, two.outputGeneratorsTwo);
+  EXPECT_NE(one.outputGeneratorsOne, one.outputGeneratorsTwo);
+  EXPECT_EQ(lazy.getStats().nrOfGenerators,
+            verified.getStats().nrOfGenerators);
+
+  // a second call on the same encoder starts with an empty generator table
+  EXPECT_FALSE(lazy.testEqual(circOne, circTwo, inputs));
+  EXPECT_EQ(lazy.getStats().nrOfGenerators,
+            verified.getStats().nrOfGenerators);
+}
+
+TEST_F(SatEncoderTest, CheckEqualWithReusedContexts) {
+  qc::QuantumComputation circOne(2);
+  circOne.h(0);
+  circOne.emplace_back<qc::StandardOperation>(2U, qc::Control{0}, 1U,
+                                              qc::OpType::X);
+  qc::QuantumComputation circTwo(2);
+  circTwo.h(0);
+  circTwo.s(1);
+
+  // contexts are replaced after every second check and after every check
+  for (const std::size_t reuses : {2U, 0U}) {
+    Z3ContextPool::setMaxReuses(reuses);
+    SatEncoder satEncoder;
+    for (std::size_t i = 0U; i < 5U; i++) {
+      const std::vector<std::string> inputs{i % 2U == 0U ? "ZZ" : "XZ"};
+      EXPECT_TRUE(satEncoder.testEqual(circOne, circOne, inputs));
+      EXPECT_FALSE(satEncoder.testEqual(circOne, circTwo, inputs));
+      EXPECT_TRUE(satEncoder.checkSatisfiability(circOne, inputs));
+    }
+  }
+  Z3ContextPool::setMaxReuses(1024U);
+}
+
+TEST_F(SatEncoderTest, CheckEqualWithParallelConstruction) {
+  std::random_device        rd;
+  std::mt19937              gen(rd());
+  qc::RandomCliffordCircuit circOne(4, 10, gen());
+  qc::CircuitOptimizer::flattenOperations(circOne);
+  auto circTwo = circOne;
+  circTwo.h(3);
+  const std::vector<std::string> inputs{"ZZZZ", "XZZZ", "ZXZZ", "ZZXZ",
+                                        "ZZZX", "YZZZ", "ZYZZ", "XXXX"};
+
+  SatEncoder sequential;
+  sequential.setConstructionThreads(1U);
+  SatEncoder parallel;
+  parallel.setConstructionThreads(3U, 0U);
+  EXPECT_TRUE(sequential.testEqual(circOne, circOne, inputs));
+  EXPECT_TRUE(parallel.testEqual(circOne, circOne, inputs));
+  EXPECT_EQ(sequential.getStats().nrOfFunctionalConstr,
+            parallel.getStats().nrOfFunctionalConstr);
+
+  EXPECT_FALSE(sequential.testEqual(circOne, circTwo, inputs));
+  EXPECT_FALSE(parallel.testEqual(circOne, circTwo, inputs));
+  EXPECT_EQ(parallel.getStats().result, EquivalenceResult::NotEquivalent);
+  ASSERT_TRUE(parallel.getCounterexample().has_value());
+  EXPECT_EQ(sequential.getStats().nrOfFunctionalConstr,
+            parallel.getStats().nrOfFunctionalConstr);
+
+  EXPECT_TRUE(parallel.checkSatisfiability(circOne, inputs));
+}
+
+TEST_F(SatEncoderTest, CheckEqualWithLayoutAndAncillas) {
+  qc::QuantumComputation circOne(2);
+  circOne.h(0);
+  circOne.emplace_back<qc::StandardOperation>(2U, qc::Control{0}, 1U,
+                                              qc::OpType::X);
+
+  // routed version of the first circuit on three physical qubits. Logical
+  // qubit 2 is an ancilla that is swapped with logical qubit 1 at the end
+  qc::QuantumComputation circTwo(3);
+  circTwo.initialLayout[0] = 1;
+  circTwo.initialLayout[1] = 0;
+  circTwo.initialLayout[2] = 2;
+  circTwo.setLogicalQubitAncillary(2);
+  circTwo.h(1);
+  circTwo.emplace_back<qc::StandardOperation>(3U, qc::Control{1}, 0U,
+                                              qc::OpType::X);
+  circTwo.emplace_back<qc::StandardOperation>(3U, qc::Control{0}, 2U,
+                                              qc::OpType::X);
+  circTwo.emplace_back<qc::StandardOperation>(3U, qc::Control{2}, 0U,
+                                              qc::OpType::X);
+  circTwo.emplace_back<qc::StandardOperation>(3U, qc::Control{0}, 2U,
+                                              qc::OpType::X);
+  circTwo.outputPermutation[0] = 2;
+  circTwo.outputPermutation[1] = 0;
+  circTwo.outputPermutation[2] = 1;
+
+  const std::vector<std::string> inputs{"zz", "Zz", "xZ", "yx"};
+  SatEncoder                     satEncoder;
+  EXPECT_TRUE(satEncoder.testEqual(circOne, circTwo, inputs));
+  EXPECT_EQ(satEncoder.getStats().nrOfQubits, 3U);
+
+  // the ancilla is |0> regardless of the input
+  EXPECT_TRUE(satEncoder.testEqual(circOne, circTwo, {"zzZ", "xZX"}));
+  // symbolic inputs propagate only Z on the ancilla
+  const auto stabilizerInputs = SatEncoder::allStabilizerInputs(3U, 3U);
+  EXPECT_TRUE(satEncoder.testEqual(circOne, circTwo, stabilizerInputs));
+  EXPECT_EQ(satEncoder.getStats().nrOfDiffInputStates, 5U);
+  qc::QuantumComputation identity(2);
+  identity.setLogicalQubitAncillary(1);
+  identity.emplace_back<qc::StandardOperation>(2U, 0U, qc::OpType::I);
+  qc::QuantumComputation phase(2);
+  phase.setLogicalQubitAncillary(1);
+  phase.s(1);
+  EXPECT_TRUE(satEncoder.testEqual(identity, phase,
+                                   SatEncoder::allStabilizerInputs(2U, 2U)));
+
+  // the routed circuit without its output permutation
+  auto circFour              = circTwo;
+  circFour.outputPermutation = circFour.initialLayout;
+  EXPECT_FALSE(satEncoder.testEqual(circOne, circFour, inputs));
+  ASSERT_TRUE(satEncoder.getCounterexample().has_value());
+  EXPECT_FALSE(satEncoder.testEqual(circOne, circFour, stabilizerInputs));
+  ASSERT_TRUE(satEncoder.getCounterexample().has_value());
+  EXPECT_EQ(satEncoder.getCounterexample()->input.back(), 'z');
+
+  // the same checks on the compact format and across processes
+  const auto converted = SatEncoder::convert(circTwo);
+  ASSERT_TRUE(converted.has_value());
+  EXPECT_NE(converted->view().outputPermutation, nullptr);
+  EXPECT_NE(converted->view().ancillary, nullptr);
+  ShardedChecker checker(2U);
+  EXPECT_TRUE(checker.testEqual(circOne, circTwo, inputs));
+  EXPECT_FALSE(checker.testEqual(circOne, circFour, inputs));
+
+  const auto directory =
+      std::filesystem::temp_directory_path() / "qusat-layout-shards";
+  std::filesystem::remove_all(directory);
+  const auto convertedOne = SatEncoder::convert(circOne);
+  const auto nrOfTasks    = checker.writeShardTasks(
+      directory.string(), convertedOne->view(), converted->view(), inputs);
+  for (std::size_t i = 0U; i < nrOfTasks; i++) {
+    ShardedChecker::runShardTask(
+        (directory / ("shard-" + std::to_string(i) + ".task.json")).string());
+  }
+  EXPECT_TRUE(checker.collectShardResults(directory.string(), nrOfTasks));
+  EXPECT_EQ(checker.getStats().result, EquivalenceResult::Equivalent);
+  std::filesystem::remove_all(directory);
+}
+
+TEST_F(SatEncoderTest, CheckNotEqualWithPermutationOnly) {
+  // circuits without gates are only accepted in preprocessed form
+  qc::QuantumComputation swapped(2);
+  swapped.outputPermutation[0] = 1;
+  swapped.outputPermutation[1] = 0;
+  const qc::QuantumComputation identity(2);
+
+  const auto prefix =
+      std::filesystem::temp_directory_path() /
+      ("qusat-permutation-" + std::to_string(std::random_device{}()));
+  const auto                     fileOne = prefix.string() + "-1.qsat";
+  const auto                     fileTwo = prefix.string() + "-2.qsat";
+  const std::vector<std::string> inputs{"zx"};
+  auto                           copy = identity;
+  EXPECT_TRUE(SatEncoder().preprocessToFile(swapped, inputs, fileOne));
+  EXPECT_TRUE(SatEncoder().preprocessToFile(copy, inputs, fileTwo));
+
+  const MappedEncoding one(fileOne);
+  const MappedEncoding two(fileTwo);
+  EXPECT_EQ(one.view().header().nrOfLevels, 1U);
+  EXPECT_EQ(two.view().header().nrOfLevels, 0U);
+  SatEncoder satEncoder;
+  EXPECT_FALSE(satEncoder.testEqual(one.view(), two.view()));
+  EXPECT_EQ(satEncoder.getStats().result, EquivalenceResult::NotEquivalent);
+  ASSERT_TRUE(satEncoder.getCounterexample().has_value());
+  EXPECT_EQ(satEncoder.getCounterexample()->outputGeneratorsOne.at(0), "+IZ");
+  EXPECT_EQ(satEncoder.getCounterexample()->outputGeneratorsTwo.at(0), "+ZI");
+
+  std::filesystem::remove(fileOne);
+  std::filesystem::remove(fileTwo);
+}
+
+TEST_F(SatEncoderTest, CheckBitSlicedAndDynamicTableausAgree) {
+  std::random_device rd;
+  std::mt19937       gen(rd());
+  // one, two, and four words per column, and the dynamic tableau
+  for (const std::size_t nrOfQubits : {5U, 70U, 130U, 260U}) {
+    qc::RandomCliffordCircuit circOne(nrOfQubits, 3, gen());
+    qc::CircuitOptimizer::flattenOperations(circOne);
+    // T gates force the dynamic tableau for the second circuit, whose
+    // generators have to be encoded exactly like the bit-sliced ones
+    auto circTwo = circOne;
+    circTwo.t(0);
+    circTwo.tdg(0);
+
+    std::string input(nrOfQubits, 'z');
+    input[0] = 'x';
+    input[1] = 'Z';
+    const std::vector<std::string> inputs{input, ""};
+    SatEncoder                     satEncoder;
+    EXPECT_TRUE(satEncoder.testEqual(circOne, circTwo, inputs));
+
+    // GHZ state, S = TT on the first qubit changes the generator X...X
+    qc::QuantumComputation ghz(nrOfQubits);
+    ghz.h(0);
+    for (std::size_t i = 1U; i < nrOfQubits; i++) {
+      ghz.emplace_back<qc::StandardOperation>(
+          nrOfQubits, qc::Control{static_cast<qc::Qubit>(i - 1U)},
+          static_cast<qc::Qubit>(i), qc::OpType::X);
+    }
+    auto withS = ghz;
+    withS.s(0);
+    auto withT = ghz;
+    withT.t(0);
+    withT.t(0);
+    EXPECT_TRUE(satEncoder.testEqual(withS, withT));
+    EXPECT_FALSE(satEncoder.testEqual(ghz, withT));
+    EXPECT_EQ(satEncoder.getStats().result, EquivalenceResult::NotEquivalent);
+  }
+}
+
+TEST_F(SatEncoderTest, CheckBatchManifest) {
+  const auto directory =
+      std::filesystem::temp_directory_path() /
+      ("qusat-batch-" + std::to_string(std::random_device{}()));
+  std::filesystem::create_directories(directory);
+  const auto write = [&directory](const std::string& name,
+                                  const std::string& contents) {
+    std::ofstream(directory / name) << contents;
+  };
+  const std::string header = "OPENQASM 2.0;\ninclude \"qelib1.inc\";\n"
+                             "qreg q[2];\nh q[0];\ncx q[0],q[1];\n";
+  write("ghz.qasm", header);
+  write("ghzId.qasm", header + "id q[1];\n");
+  write("ghzX.qasm", header + "x q[1];\n");
+  write("manifest.jsonl",
+        "{\"id\": \"same\", \"circuitOne\": \"ghz.qasm\", "
+        "\"circuitTwo\": \"ghzId.qasm\"}\n"
+        "\n"
+        "{\"circuitOne\": \"ghz.qasm\", \"circuitTwo\": \"ghzX.qasm\", "
+        "\"inputs\": [\"ZZ\"]}\n"
+        "{\"circuitOne\": \"ghz.qasm\", \"circuitTwo\": \"missing.qasm\"}\n");
+
+  std::stringstream output{};
+  const BatchRunner runner(2U);
+  EXPECT_EQ(runner.run((directory / "manifest.jsonl").string(), output), 1U);
+  std::map<std::size_t, json> results{};
+  std::string                 line{};
+  while (std::getline(output, line)) {
+    const auto result = json::parse(line);
+    results.emplace(result.at("line").get<std::size_t>(), result);
+  }
+  ASSERT_EQ(results.size(), 3U);
+  EXPECT_EQ(results[1].at("id"), "same");
+  EXPECT_TRUE(results[1].at("equivalent").get<bool>());
+  EXPECT_TRUE(results[1].at("counterexample").is_null());
+  EXPECT_EQ(results[3].at("id"), "3");
+  EXPECT_EQ(results[3].at("result"), "not_equivalent");
+  EXPECT_EQ(results[3].at("counterexample").at("input"), "ZZ");
+  EXPECT_TRUE(results[3].at("statistics").contains("solvingTime"));
+  EXPECT_TRUE(results[4].contains("error"));
+  std::filesystem::remove_all(directory);
+}
+
+TEST_F(SatEncoderTest, CheckEqualAfterEdits) {
+  const auto gates = hadamardCnotRounds();
+  const CliffordCircuit circuit{4U, gates.data(), gates.size()};
+
+  SatEncoder satEncoder;
+  EXPECT_TRUE(satEncoder.testEqualIncremental(circuit, circuit, {}));
+  const auto depth = satEncoder.getStats().circuitDepth;
+
+  // every edit is compared to a check of the edited circuits from scratch
+  std::array<std::vector<CliffordGate>, 2U> edited{gates, gates};
+  const auto edit = [&](const SatEncoder::CircuitEdit& circuitEdit) {
+    auto&      target = edited.at(circuitEdit.circuit);
+    const auto begin =
+        target.begin() + static_cast<std::ptrdiff_t>(circuitEdit.begin);
+    target.erase(begin, begin + static_cast<std::ptrdiff_t>(
+                                    circuitEdit.end - circuitEdit.begin));
+    target.insert(target.begin() +
+                      static_cast<std::ptrdiff_t>(circuitEdit.begin),
+                  circuitEdit.gates.begin(), circuitEdit.gates.end());
+    const auto result = satEncoder.testEqualAfterEdit(circuitEdit);
+    SatEncoder fresh;
+    EXPECT_EQ(result,
+              fresh.testEqual({4U, edited[0].data(), edited[0].size()},
+                              {4U, edited[1].data(), edited[1].size()}, {}));
+    return result;
+  };
+
+  const auto lastRound = gates.size() - 7U;
+  EXPECT_FALSE(edit({1U, lastRound, lastRound, {gate(GateType::X, -1, 2)}}));
+  EXPECT_EQ(satEncoder.getStats().result, EquivalenceResult::NotEquivalent);
+  EXPECT_TRUE(satEncoder.getCounterexample().has_value());
+  EXPECT_LT(satEncoder.getStats().nrOfResimulatedLevels, depth);
+  EXPECT_TRUE(edit({1U, lastRound, lastRound + 1U}));
+
+  const std::vector<CliffordGate> identity{gate(GateType::H, -1, 3),
+                                           gate(GateType::H, -1, 3)};
+  edit({1U, lastRound, lastRound, identity});
+  EXPECT_TRUE(edit({0U, lastRound, lastRound, identity}));
+  // a new first level of the deepest qubit affects all levels
+  edit({0U, 0U, 0U, {gate(GateType::S, -1, 1)}});
+  EXPECT_EQ(satEncoder.getStats().nrOfResimulatedLevels, depth + 1U);
+
+  EXPECT_FALSE(satEncoder.testEqualAfterEdit({1U, 0U, gates.size() + 10U}));
+  EXPECT_EQ(satEncoder.getStats().unknownReason, "invalid edit");
+  EXPECT_TRUE(edit({0U, 0U, 1U}));
+}
+
+TEST_F(SatEncoderTest, CheckEqualAfterEditsOnOtherThreads) {
+  const std::vector<CliffordGate> gates{
+      {static_cast<std::uint8_t>(GateType::H), -1, 0},
+      {static_cast<std::uint8_t>(GateType::X), 0, 1}};
+  const CliffordCircuit circuit{2U, gates.data(), gates.size()};
+  const CliffordGate    swapped{static_cast<std::uint8_t>(GateType::X), 1, 0};
+
+  // the kept state outlives the thread that started the check
+  auto satEncoder = std::make_unique<SatEncoder>();
+  std::thread([&]() {
+    EXPECT_TRUE(satEncoder->testEqualIncremental(circuit, circuit, {"xz"}));
+  }).join();
+  std::thread([&]() {
+    EXPECT_FALSE(satEncoder->testEqualAfterEdit({1U, 1U, 2U, {swapped}}));
+    EXPECT_TRUE(satEncoder->testEqualAfterEdit({0U, 1U, 2U, {swapped}}));
+  }).join();
+  std::thread([&]() { satEncoder.reset(); }).join();
+}
+
+TEST_F(SatEncoderTest, CheckCounterexampleFromCheckpoints) {
+  const auto gates = hadamardCnotRounds();
+  auto withT = gates;
+  withT.insert(withT.begin() + 20, gate(GateType::T, -1, 2));
+  const CliffordCircuit circuit{4U, gates.data(), gates.size()};
+  const CliffordCircuit other{4U, withT.data(), withT.size()};
+
+  SatEncoder replayed;
+  EXPECT_FALSE(replayed.testEqual(circuit, other, {"xzZz"}));
+  EXPECT_EQ(replayed.getStats().nrOfCheckpoints, 0U);
+  SatEncoder checkpointed;
+  checkpointed.setCheckpoints(3U);
+  EXPECT_FALSE(checkpointed.testEqual(circuit, other, {"xzZz"}));
+  EXPECT_GT(checkpointed.getStats().nrOfCheckpoints, 0U);
+  ASSERT_TRUE(replayed.getCounterexample().has_value());
+  ASSERT_TRUE(checkpointed.getCounterexample().has_value());
+  EXPECT_EQ(replayed.getCounterexample()->to_json(),
+            checkpointed.getCounterexample()->to_json());
+}
+
+TEST_F(SatEncoderTest, CheckCheckpointsWithinMemoryLimit) {
+  constexpr std::size_t nrOfQubits = 64U;
+  qc::QuantumComputation circuit(nrOfQubits);
+  for (std::size_t round = 0U; round < 10U; round++) {
+    for (std::size_t qubit = 0U; qubit < nrOfQubits; qubit++) {
+      circuit.h(static_cast<qc::Qubit>(qubit));
+    }
+    for (std::size_t qubit = 0U; qubit + 1U < nrOfQubits; qubit++) {
+      circuit.emplace_back<qc::StandardOperation>(
+          nrOfQubits, qc::Control{static_cast<qc::Qubit>(qubit)},
+          static_cast<qc::Qubit>(qubit + 1U), qc::OpType::X);
+    }
+  }
+  auto                     copy = circuit;
+  std::vector<std::string> inputs{};
+  for (std::size_t i = 0U; i < 100U; i++) {
+    std::string input(nrOfQubits, 'z');
+    input[i % nrOfQubits]         = 'x';
+    input[(i * 7U) % nrOfQubits] = 'Y';
+    inputs.emplace_back(input);
+  }
+
+  SatEncoder unlimited;
+  unlimited.setCheckpoints(1U, 0U);
+  EXPECT_TRUE(unlimited.testEqual(circuit, copy, inputs));
+  SatEncoder limited;
+  limited.setCheckpoints(1U, 1U);
+  EXPECT_TRUE(limited.testEqual(circuit, copy, inputs));
+  EXPECT_GT(limited.getStats().nrOfCheckpoints, 0U);
+  EXPECT_LT(limited.getStats().nrOfCheckpoints,
+            unlimited.getStats().nrOfCheckpoints / 2U);
+}
+
 /* Benchmarking */
 std::vector<std::string> getAllCompBasisStates(std::size_t nrQubits) {
   if (nrQubits == 1) {